@@ -0,0 +1,136 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5attribute.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5attribute.h"
+
+namespace h5 {
+
+    herr_t write_attribute(hid_t object, std::string name, hid_t dtype, const void *data, hsize_t n) {
+        if (H5Aexists(object, name.c_str()) > 0)
+            H5Adelete(object, name.c_str());
+
+        hid_t space = H5Screate_simple(1, &n, NULL);
+        hid_t attribute = H5Acreate2(object, name.c_str(), dtype, space, H5P_DEFAULT, H5P_DEFAULT);
+        H5Sclose(space);
+
+        if (attribute < 0)
+            return -1;
+
+        herr_t status = H5Awrite(attribute, dtype, data);
+        H5Aclose(attribute);
+
+        return status;
+    }
+
+    //Strings are stored as a fixed length, null terminated scalar
+    herr_t write_attribute(hid_t object, std::string name, std::string value) {
+        if (H5Aexists(object, name.c_str()) > 0)
+            H5Adelete(object, name.c_str());
+
+        hid_t dtype = H5Tcopy(H5T_C_S1);
+        H5Tset_size(dtype, value.size() + 1);
+
+        hid_t space = H5Screate(H5S_SCALAR);
+        hid_t attribute = H5Acreate2(object, name.c_str(), dtype, space, H5P_DEFAULT, H5P_DEFAULT);
+        H5Sclose(space);
+
+        herr_t status = -1;
+        if (attribute >= 0) {
+            status = H5Awrite(attribute, dtype, value.c_str());
+            H5Aclose(attribute);
+        }
+
+        H5Tclose(dtype);
+        return status;
+    }
+
+    bool has_attribute(hid_t object, std::string name) {
+        return H5Aexists(object, name.c_str()) > 0;
+    }
+
+    hssize_t attribute_size(hid_t object, std::string name) {
+        if (!has_attribute(object, name))
+            return -1;
+
+        hid_t attribute = H5Aopen(object, name.c_str(), H5P_DEFAULT);
+        hid_t space = H5Aget_space(attribute);
+        hssize_t n = H5Sget_simple_extent_npoints(space);
+        H5Sclose(space);
+        H5Aclose(attribute);
+
+        return n;
+    }
+
+    herr_t read_attribute(hid_t object, std::string name, hid_t dtype, void *data) {
+        if (!has_attribute(object, name))
+            return -1;
+
+        hid_t attribute = H5Aopen(object, name.c_str(), H5P_DEFAULT);
+        herr_t status = H5Aread(attribute, dtype, data);
+        H5Aclose(attribute);
+
+        return status;
+    }
+
+    herr_t read_attribute(hid_t object, std::string name, std::string &value) {
+        if (!has_attribute(object, name))
+            return -1;
+
+        hid_t attribute = H5Aopen(object, name.c_str(), H5P_DEFAULT);
+        hid_t file_dtype = H5Aget_type(attribute);
+
+        hid_t dtype = H5Tcopy(H5T_C_S1);
+        H5Tset_size(dtype, H5Tget_size(file_dtype));
+
+        std::vector<char> buffer(H5Tget_size(file_dtype) + 1, '\0');
+        herr_t status = H5Aread(attribute, dtype, buffer.data());
+        value = buffer.data();
+
+        H5Tclose(dtype);
+        H5Tclose(file_dtype);
+        H5Aclose(attribute);
+
+        return status;
+    }
+
+}
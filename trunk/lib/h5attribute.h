@@ -0,0 +1,90 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5attribute.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5ATTRIBUTE
+#define _H_H5ATTRIBUTE
+
+#include <hdf5.h>
+#include <string>
+#include <vector>
+
+#include "h5datatype.h"
+
+namespace h5 {
+
+    /**
+     * Attributes of HDF5 objects, e.g. of a dataset's id(). Attributes are one dimensional
+     * arrays, an existing attribute of the same name is replaced on write.
+     */
+    herr_t write_attribute(hid_t object, std::string name, hid_t dtype, const void *data, hsize_t n);
+    herr_t write_attribute(hid_t object, std::string name, std::string value);
+
+    bool has_attribute(hid_t object, std::string name);
+    hssize_t attribute_size(hid_t object, std::string name);    // Number of elements, -1 if absent
+
+    herr_t read_attribute(hid_t object, std::string name, hid_t dtype, void *data);
+    herr_t read_attribute(hid_t object, std::string name, std::string &value);
+
+    template<typename T>
+    herr_t write_attribute(hid_t object, std::string name, const std::vector<T> &values) {
+        return write_attribute(object, name, Dtype(NativeDtype<T>::name()), values.data(), values.size());
+    }
+
+    template<typename T>
+    herr_t write_attribute(hid_t object, std::string name, T value) {
+        return write_attribute(object, name, Dtype(NativeDtype<T>::name()), &value, 1);
+    }
+
+    template<typename T>
+    herr_t read_attribute(hid_t object, std::string name, std::vector<T> &values) {
+        hssize_t n = attribute_size(object, name);
+
+        if (n < 0)
+            return -1;
+
+        values.resize(n);
+        return read_attribute(object, name, Dtype(NativeDtype<T>::name()), values.data());
+    }
+}
+
+#endif
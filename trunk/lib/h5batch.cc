@@ -0,0 +1,204 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5batch.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5batch.h"
+
+#include "h5convert.h"
+
+#include <iostream>
+
+namespace h5 {
+
+    Batch::Batch():collective_(false) { }
+
+    Batch::~Batch() {
+        this->clear();
+    }
+
+    //Add a transfer in the native format of the dataset's datatype
+    Batch &Batch::add(const Dataset &ds, const void *data) {
+        this->native_dtype_.push_back(Convert::native_dtype(ds.dtype()));
+        return this->add(ds, this->native_dtype_.back(), data);
+    }
+
+    //Add a transfer of data, in memory datatype dtype, using the plan of the dataset
+    //The dataset and spaces are kept open by the batch until clear().
+    Batch &Batch::add(const Dataset &ds, hid_t dtype, const void *data) {
+        this->dataset_.push_back(ds.id());
+        this->dtype_.push_back(dtype);
+        this->memoryspace_.push_back(ds.plan.memoryspace());
+        this->filespace_.push_back(ds.plan.filespace());
+        this->data_.push_back(data);
+        this->name_.push_back(ds.name());
+        this->write_hooks_.push_back(ds.write_hooks());
+
+        H5Iinc_ref(this->dataset_.back());
+        H5Iinc_ref(this->memoryspace_.back());
+        H5Iinc_ref(this->filespace_.back());
+
+        if (ds.driver() == "mpio") {
+            this->collective_ = true;
+#ifdef H5SI_ENABLE_MPI
+            this->comm_ = ds.MPI_COMMUNICATOR;
+#endif
+        }
+
+        return *this;
+    }
+
+    size_t Batch::size() const {
+        return this->dataset_.size();
+    }
+
+    void Batch::clear() {
+        for (std::vector<hid_t>::size_type i=0; i<this->dataset_.size(); i++) {
+            H5Idec_ref(this->dataset_[i]);
+            H5Idec_ref(this->memoryspace_[i]);
+            H5Idec_ref(this->filespace_[i]);
+        }
+
+        this->dataset_.clear();
+        this->dtype_.clear();
+        this->memoryspace_.clear();
+        this->filespace_.clear();
+        this->data_.clear();
+        this->name_.clear();
+        this->write_hooks_.clear();
+        this->collective_ = false;
+
+        for (std::vector<hid_t>::size_type i=0; i<this->native_dtype_.size(); i++)
+            H5Tclose(this->native_dtype_[i]);
+        this->native_dtype_.clear();
+    }
+
+    hid_t Batch::create_dxpl() const {
+        hid_t dxpl = H5Pcreate(H5P_DATASET_XFER);
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->collective_)
+            H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+#endif
+
+        return dxpl;
+    }
+
+    //Whether no transfer of the batch is split, on all processes of collective transfers
+    bool Batch::fits() const {
+        int fits = 1;
+        for (std::vector<hid_t>::size_type i=0; i<this->dataset_.size(); i++)
+            if (!Dataset::fits_transfer(this->dataset_[i], this->dtype_[i], this->memoryspace_[i]))
+                fits = 0;
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->collective_)
+            MPI_Allreduce(MPI_IN_PLACE, &fits, 1, MPI_INT, MPI_MIN, this->comm_);
+#endif
+
+        return fits;
+    }
+
+    /**
+     * All transfers of the batch, together with H5Dwrite_multi/H5Dread_multi where available.
+     * Otherwise, or when a transfer must be split, one dataset at a time with Dataset's
+     * transfer(), independent once split as the processes split into different numbers of parts.
+     */
+    herr_t Batch::transfer(bool is_write) const {
+        herr_t status = 0;
+        hid_t dxpl = this->create_dxpl();
+        bool fits = this->fits();
+
+        std::vector<void*> data(this->data_.size());
+        for (std::vector<const void*>::size_type i=0; i<this->data_.size(); i++)
+            data[i] = const_cast<void*>(this->data_[i]);
+
+#if H5_VERSION_GE(1,14,0)
+        if (fits) {
+            std::vector<hid_t> dataset = this->dataset_;
+            std::vector<hid_t> dtype = this->dtype_;
+            std::vector<hid_t> memoryspace = this->memoryspace_;
+            std::vector<hid_t> filespace = this->filespace_;
+
+            if (is_write) {
+                std::vector<const void*> write_data = this->data_;
+                status = H5Dwrite_multi(dataset.size(), dataset.data(), dtype.data(), memoryspace.data(), filespace.data(), dxpl, write_data.data());
+            }
+            else
+                status = H5Dread_multi(dataset.size(), dataset.data(), dtype.data(), memoryspace.data(), filespace.data(), dxpl, data.data());
+
+            H5Pclose(dxpl);
+            return status;
+        }
+#endif
+
+        //Plain loop, no aggregation before H5Dwrite_multi/H5Dread_multi
+        hid_t part_dxpl = (fits ? dxpl : H5P_DEFAULT);
+        for (std::vector<hid_t>::size_type i=0; i<this->dataset_.size(); i++)
+            if (Dataset::transfer(this->dataset_[i], part_dxpl, is_write, this->dtype_[i], this->memoryspace_[i], this->filespace_[i], data[i]) < 0)
+                status = -1;
+
+        H5Pclose(dxpl);
+        return status;
+    }
+
+    herr_t Batch::write() const {
+        if (this->dataset_.empty())
+            return 0;
+
+        for (std::vector<std::string>::size_type i=0; i<this->write_hooks_.size(); i++) {
+            if (!this->write_hooks_[i].empty()) {
+                std::cerr << "Batch::write: " << this->name_[i] << " has " << this->write_hooks_[i] << ", which a batch does not update, write it with Dataset::write()" << std::endl;
+                return -1;
+            }
+        }
+
+        return this->transfer(true);
+    }
+
+    herr_t Batch::read() const {
+        if (this->dataset_.empty())
+            return 0;
+
+        return this->transfer(false);
+    }
+
+}
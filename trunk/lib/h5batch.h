@@ -0,0 +1,122 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5batch.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5BATCH
+#define _H_H5BATCH
+
+#include <hdf5.h>
+#include <vector>
+#include <string>
+
+#include "h5dataset.h"
+#include "h5datatype.h"
+
+namespace h5 {
+
+    /**
+     * Reads or writes several datasets in one call, e.g. all fields of a checkpoint.
+     *
+     *     h5::Batch batch;
+     *     batch.add(ds_V1, V1.data()).add(ds_V2, V2.data()).add(ds_p, p.data());
+     *     batch.write();
+     *
+     * With HDF5 >= 1.14 the transfers are submitted together with H5Dwrite_multi/H5Dread_multi,
+     * which HDF5 may aggregate into fewer file accesses. Older versions have no such call, there
+     * write() and read() are a plain loop of H5Dwrite/H5Dread with one shared transfer property
+     * list, which aggregates nothing. Under mpio the transfers are collective, so all processes
+     * must add the same datasets in the same order.
+     *
+     * Transfers larger than Dataset::set_max_transfer_size() are split as in Dataset::write().
+     * The processes split into different numbers of parts, so when any of them has such a
+     * transfer, all processes make the batch one dataset at a time with independent transfers.
+     *
+     * add() takes a reference to the dataset and the plan's spaces, the Dataset may be closed or
+     * destroyed before write() or read(). write() refuses datasets with write-time features, such
+     * as statistics, which only Dataset::write() keeps up to date, see Dataset::write_hooks().
+     */
+    class Batch
+    {
+        std::vector<hid_t> dataset_;
+        std::vector<hid_t> dtype_;
+        std::vector<hid_t> memoryspace_;
+        std::vector<hid_t> filespace_;
+        std::vector<const void*> data_;
+        std::vector<std::string> name_;
+        std::vector<std::string> write_hooks_;    // Dataset::write_hooks() of each dataset
+
+        std::vector<hid_t> native_dtype_;   // Native datatypes created by add(), closed by clear()
+
+        bool collective_;
+#ifdef H5SI_ENABLE_MPI
+        MPI_Comm comm_;                     // Communicator of the collective transfers
+#endif
+
+        hid_t create_dxpl() const;
+        bool fits() const;
+        herr_t transfer(bool is_write) const;
+
+        Batch(const Batch &batch);
+        Batch &operator=(const Batch &batch);
+
+    public:
+        Batch();
+        ~Batch();
+
+        Batch &add(const Dataset &ds, const void *data);
+        Batch &add(const Dataset &ds, hid_t dtype, const void *data);
+
+        template<typename T>
+        Batch &add(const Dataset &ds, const T *data) {
+            return this->add(ds, Dtype(NativeDtype<T>::name()), data);
+        }
+
+        size_t size() const;
+        void clear();
+
+        herr_t write() const;
+        herr_t read() const;        // Buffers given to add() must be writable
+    };
+
+}
+
+#endif
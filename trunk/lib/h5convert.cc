@@ -0,0 +1,375 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5convert.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5convert.h"
+
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+namespace h5 {
+
+    //Floating point to floating point, overflow gives infinity as in HDF5
+    template<typename S, typename D>
+    static void Convert_float_(const S * __restrict__ src, D * __restrict__ dst, size_t n) {
+        for (size_t i=0; i<n; i++)
+            dst[i] = static_cast<D>(src[i]);
+    }
+
+    //Integer to integer, values out of range of D are clipped
+    template<typename S, typename D>
+    static void Convert_integer_(const S * __restrict__ src, D * __restrict__ dst, size_t n) {
+        const bool clip_high = double(std::numeric_limits<D>::max()) < double(std::numeric_limits<S>::max());
+        const bool clip_low = double(std::numeric_limits<D>::min()) > double(std::numeric_limits<S>::min());
+
+        const S high = clip_high ? static_cast<S>(std::numeric_limits<D>::max()) : std::numeric_limits<S>::max();
+        const S low = clip_low ? static_cast<S>(std::numeric_limits<D>::min()) : std::numeric_limits<S>::min();
+
+        for (size_t i=0; i<n; i++) {
+            S value = src[i];
+            value = (value < low ? low : value);
+            value = (value > high ? high : value);
+            dst[i] = static_cast<D>(value);
+        }
+    }
+
+    static inline uint32_t Float_bits_(float f) {
+        uint32_t u;
+        memcpy(&u, &f, 4);
+        return u;
+    }
+
+    static inline float Bits_float_(uint32_t u) {
+        float f;
+        memcpy(&f, &u, 4);
+        return f;
+    }
+
+    //IEEE half precision from float, rounding to nearest even
+    static inline uint16_t Float_to_half_(float f) {
+        const uint32_t infinity = 255u << 23;
+        const uint32_t half_overflow = (127u + 16) << 23;
+        const uint32_t denormal_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+        uint32_t u = Float_bits_(f);
+        uint32_t sign = u & 0x80000000u;
+        uint16_t h;
+
+        u ^= sign;
+
+        if (u >= half_overflow)
+            h = (u > infinity ? 0x7e00 : 0x7c00);
+        else if (u < (113u << 23))
+            h = Float_bits_(Bits_float_(u) + Bits_float_(denormal_magic)) - denormal_magic;
+        else {
+            uint32_t mantissa_odd = (u >> 13) & 1;
+            u += (uint32_t(15 - 127) << 23) + 0xfff + mantissa_odd;
+            h = u >> 13;
+        }
+
+        return h | (sign >> 16);
+    }
+
+    static inline float Half_to_float_(uint16_t h) {
+        const uint32_t shifted_exponent = 0x7c00u << 13;
+
+        uint32_t u = (h & 0x7fffu) << 13;
+        uint32_t exponent = shifted_exponent & u;
+
+        u += (127u - 15) << 23;
+
+        if (exponent == shifted_exponent)
+            u += (128u - 16) << 23;
+        else if (exponent == 0) {
+            u += 1u << 23;
+            u = Float_bits_(Bits_float_(u) - Bits_float_(113u << 23));
+        }
+
+        return Bits_float_(u | ((h & 0x8000u) << 16));
+    }
+
+    //bfloat16 from float, rounding to nearest even, NaNs stay quiet NaNs
+    static inline uint16_t Float_to_bfloat16_(float f) {
+        uint32_t u = Float_bits_(f);
+
+        if ((u & 0x7fffffffu) > 0x7f800000u)
+            return (u >> 16) | 0x40;
+
+        return (u + 0x7fffu + ((u >> 16) & 1)) >> 16;
+    }
+
+    static inline float Bfloat16_to_float_(uint16_t b) {
+        return Bits_float_(uint32_t(b) << 16);
+    }
+
+    static void Float_to_half_array_(const float * __restrict__ src, uint16_t * __restrict__ dst, size_t n) {
+        size_t i = 0;
+#ifdef __F16C__
+        for (; i+8<=n; i+=8)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i), _mm256_cvtps_ph(_mm256_loadu_ps(src+i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+        for (; i<n; i++)
+            dst[i] = Float_to_half_(src[i]);
+    }
+
+    static void Half_to_float_array_(const uint16_t * __restrict__ src, float * __restrict__ dst, size_t n) {
+        size_t i = 0;
+#ifdef __F16C__
+        for (; i+8<=n; i+=8)
+            _mm256_storeu_ps(dst+i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i))));
+#endif
+        for (; i<n; i++)
+            dst[i] = Half_to_float_(src[i]);
+    }
+
+    static void Float_to_bfloat16_array_(const float * __restrict__ src, uint16_t * __restrict__ dst, size_t n) {
+        for (size_t i=0; i<n; i++)
+            dst[i] = Float_to_bfloat16_(src[i]);
+    }
+
+    static void Bfloat16_to_float_array_(const uint16_t * __restrict__ src, float * __restrict__ dst, size_t n) {
+        for (size_t i=0; i<n; i++)
+            dst[i] = Bfloat16_to_float_(src[i]);
+    }
+
+    //Floating point to a 16 bit float, doubles go through float in blocks that stay in cache
+    static void To_16_bit_(Convert::Kind dst_kind, const float *src, uint16_t *dst, size_t n) {
+        if (dst_kind == Convert::HALF)
+            Float_to_half_array_(src, dst, n);
+        else
+            Float_to_bfloat16_array_(src, dst, n);
+    }
+
+    static void To_16_bit_(Convert::Kind dst_kind, const double *src, uint16_t *dst, size_t n) {
+        const size_t block = 1024;
+        float values[block];
+
+        for (size_t i=0; i<n; i+=block) {
+            size_t m = std::min(block, n-i);
+            Convert_float_(src+i, values, m);
+            To_16_bit_(dst_kind, values, dst+i, m);
+        }
+    }
+
+    template<typename S>
+    static void Convert_from_(Convert::Kind dst_kind, const S *src, void *dst, size_t n) {
+        switch (dst_kind) {
+            case Convert::INT8:   Convert_integer_(src, static_cast<int8_t*>(dst), n); break;
+            case Convert::UINT8:  Convert_integer_(src, static_cast<uint8_t*>(dst), n); break;
+            case Convert::INT16:  Convert_integer_(src, static_cast<int16_t*>(dst), n); break;
+            case Convert::UINT16: Convert_integer_(src, static_cast<uint16_t*>(dst), n); break;
+            case Convert::INT32:  Convert_integer_(src, static_cast<int32_t*>(dst), n); break;
+            case Convert::UINT32: Convert_integer_(src, static_cast<uint32_t*>(dst), n); break;
+            case Convert::INT64:  Convert_integer_(src, static_cast<int64_t*>(dst), n); break;
+            case Convert::UINT64: Convert_integer_(src, static_cast<uint64_t*>(dst), n); break;
+            case Convert::FLOAT:  Convert_float_(src, static_cast<float*>(dst), n); break;
+            case Convert::DOUBLE: Convert_float_(src, static_cast<double*>(dst), n); break;
+            default: break;
+        }
+    }
+
+    template<typename S>
+    static void Convert_from_float_(Convert::Kind dst_kind, const S *src, void *dst, size_t n) {
+        switch (dst_kind) {
+            case Convert::FLOAT:  Convert_float_(src, static_cast<float*>(dst), n); break;
+            case Convert::DOUBLE: Convert_float_(src, static_cast<double*>(dst), n); break;
+            case Convert::HALF:
+            case Convert::BFLOAT16: To_16_bit_(dst_kind, src, static_cast<uint16_t*>(dst), n); break;
+            default: break;
+        }
+    }
+
+    //From a 16 bit float through float in blocks that stay in cache
+    static void Convert_from_16_bit_(Convert::Kind src_kind, Convert::Kind dst_kind, const uint16_t *src, void *dst, size_t n) {
+        if (src_kind == dst_kind) {
+            memcpy(dst, src, 2*n);
+            return;
+        }
+
+        if (dst_kind == Convert::FLOAT) {
+            if (src_kind == Convert::HALF)
+                Half_to_float_array_(src, static_cast<float*>(dst), n);
+            else
+                Bfloat16_to_float_array_(src, static_cast<float*>(dst), n);
+            return;
+        }
+
+        const size_t block = 1024;
+        float values[block];
+
+        for (size_t i=0; i<n; i+=block) {
+            size_t m = std::min(block, n-i);
+
+            if (src_kind == Convert::HALF)
+                Half_to_float_array_(src+i, values, m);
+            else
+                Bfloat16_to_float_array_(src+i, values, m);
+
+            if (dst_kind == Convert::DOUBLE)
+                Convert_float_(values, static_cast<double*>(dst)+i, m);
+            else
+                To_16_bit_(dst_kind, values, static_cast<uint16_t*>(dst)+i, m);
+        }
+    }
+
+    //Kind of a native datatype, NONE if it is not handled here
+    Convert::Kind Convert::kind(hid_t dtype) {
+        switch (H5Tget_class(dtype)) {
+            case H5T_FLOAT:
+                if (H5Tequal(dtype, H5T_NATIVE_FLOAT) > 0)
+                    return FLOAT;
+                if (H5Tequal(dtype, H5T_NATIVE_DOUBLE) > 0)
+                    return DOUBLE;
+
+                if (H5Tget_size(dtype) == 2 && H5Tget_order(dtype) == H5Tget_order(H5T_NATIVE_FLOAT)) {
+                    size_t sign_position, exponent_position, exponent_size, mantissa_position, mantissa_size;
+                    H5Tget_fields(dtype, &sign_position, &exponent_position, &exponent_size, &mantissa_position, &mantissa_size);
+
+                    if (sign_position == 15 && exponent_size == 5 && mantissa_size == 10 && H5Tget_ebias(dtype) == 15)
+                        return HALF;
+                    if (sign_position == 15 && exponent_size == 8 && mantissa_size == 7 && H5Tget_ebias(dtype) == 127)
+                        return BFLOAT16;
+                }
+                return NONE;
+
+            case H5T_INTEGER: {
+                if (H5Tget_order(dtype) != H5Tget_order(H5T_NATIVE_INT))
+                    return NONE;
+
+                bool is_signed = (H5Tget_sign(dtype) == H5T_SGN_2);
+
+                switch (H5Tget_size(dtype)) {
+                    case 1: return (is_signed ? INT8 : UINT8);
+                    case 2: return (is_signed ? INT16 : UINT16);
+                    case 4: return (is_signed ? INT32 : UINT32);
+                    case 8: return (is_signed ? INT64 : UINT64);
+                    default: return NONE;
+                }
+            }
+
+            default:
+                return NONE;
+        }
+    }
+
+    //Datatype in which dtype is transferred to and from memory: the 16 bit floats handled here as
+    //they are, otherwise HDF5's native type. The caller must close it.
+    hid_t Convert::native_dtype(hid_t dtype) {
+        Kind dtype_kind = kind(dtype);
+
+        if (dtype_kind == HALF || dtype_kind == BFLOAT16)
+            return H5Tcopy(dtype);
+
+        return H5Tget_native_type(dtype, H5T_DIR_ASCEND);
+    }
+
+    bool Convert::isSupported(hid_t src_dtype, hid_t dst_dtype) {
+        Kind src_kind = kind(src_dtype);
+        Kind dst_kind = kind(dst_dtype);
+
+        if (src_kind == NONE || dst_kind == NONE || src_kind == dst_kind)
+            return false;
+
+        bool src_float = (src_kind == FLOAT || src_kind == DOUBLE || src_kind == HALF || src_kind == BFLOAT16);
+        bool dst_float = (dst_kind == FLOAT || dst_kind == DOUBLE || dst_kind == HALF || dst_kind == BFLOAT16);
+
+        return (src_float == dst_float);
+    }
+
+    void Convert::run(hid_t src_dtype, hid_t dst_dtype, const void *src, void *dst, size_t n) {
+        run(kind(src_dtype), kind(dst_dtype), src, dst, n);
+    }
+
+    void Convert::run(Kind src_kind, Kind dst_kind, const void *src, void *dst, size_t n) {
+        switch (src_kind) {
+            case INT8:   Convert_from_(dst_kind, static_cast<const int8_t*>(src), dst, n); break;
+            case UINT8:  Convert_from_(dst_kind, static_cast<const uint8_t*>(src), dst, n); break;
+            case INT16:  Convert_from_(dst_kind, static_cast<const int16_t*>(src), dst, n); break;
+            case UINT16: Convert_from_(dst_kind, static_cast<const uint16_t*>(src), dst, n); break;
+            case INT32:  Convert_from_(dst_kind, static_cast<const int32_t*>(src), dst, n); break;
+            case UINT32: Convert_from_(dst_kind, static_cast<const uint32_t*>(src), dst, n); break;
+            case INT64:  Convert_from_(dst_kind, static_cast<const int64_t*>(src), dst, n); break;
+            case UINT64: Convert_from_(dst_kind, static_cast<const uint64_t*>(src), dst, n); break;
+            case FLOAT:  Convert_from_float_(dst_kind, static_cast<const float*>(src), dst, n); break;
+            case DOUBLE: Convert_from_float_(dst_kind, static_cast<const double*>(src), dst, n); break;
+            case HALF:
+            case BFLOAT16: Convert_from_16_bit_(src_kind, dst_kind, static_cast<const uint16_t*>(src), dst, n); break;
+            default: break;
+        }
+    }
+
+    //Round n floats or doubles in place to 'bits' explicit mantissa bits, to nearest with ties
+    //away from zero. Infinities and NaNs are left alone, values may round up to infinity.
+    template<typename U, int mantissa_bits, int exponent_mask_shift>
+    static void Trim_mantissa_(U * __restrict__ data, size_t n, int bits) {
+        if (bits >= mantissa_bits)
+            return;
+
+        const int drop = mantissa_bits - bits;
+        const U half = U(1) << (drop-1);
+        const U mask = ~((U(1) << drop) - 1);
+        const U exponent = (~U(0) >> (8*sizeof(U) - exponent_mask_shift)) << mantissa_bits;
+
+        for (size_t i=0; i<n; i++) {
+            U u = data[i];
+            U trimmed = (u + half) & mask;
+            data[i] = ((u & exponent) == exponent ? u : trimmed);
+        }
+    }
+
+    void Convert::trim_mantissa(Kind kind, void *data, size_t n, int bits) {
+        if (bits < 0)
+            return;
+
+        if (kind == FLOAT)
+            Trim_mantissa_<uint32_t, 23, 8>(static_cast<uint32_t*>(data), n, bits);
+        else if (kind == DOUBLE)
+            Trim_mantissa_<uint64_t, 52, 11>(static_cast<uint64_t*>(data), n, bits);
+    }
+
+}
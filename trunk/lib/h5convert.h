@@ -0,0 +1,86 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5convert.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5CONVERT
+#define _H_H5CONVERT
+
+#include <hdf5.h>
+#include <cstddef>
+
+namespace h5 {
+
+    /**
+     * Datatype conversion done by the library instead of HDF5's soft conversion path,
+     * used when the memory and file datatypes of a transfer differ, e.g. double in memory
+     * and float on disk.
+     *
+     * Supported are native floating point types (float <-> double) and native integer
+     * types of any width and signedness. Integers saturate like HDF5's hard conversions do.
+     * run() also converts integers to float and double, as used by reductions and statistics.
+     *
+     * The 16 bit floating point types "f16" (IEEE half precision) and "bf16" (bfloat16) of
+     * the Dtype table are converted here too, rounding to nearest even, with the F16C
+     * instructions when the compiler targets them. HDF5 has no native type for them, so
+     * native_dtype() gives them as is to keep HDF5's soft conversion out of transfers.
+     * The kernels are plain loops over restrict pointers, which the compiler vectorizes.
+     */
+    class Convert {
+
+    public:
+        enum Kind { NONE, INT8, UINT8, INT16, UINT16, INT32, UINT32, INT64, UINT64, FLOAT, DOUBLE, HALF, BFLOAT16 };
+
+        static Kind kind(hid_t dtype);
+
+        static hid_t native_dtype(hid_t dtype);
+
+        static bool isSupported(hid_t src_dtype, hid_t dst_dtype);
+
+        static void run(hid_t src_dtype, hid_t dst_dtype, const void *src, void *dst, size_t n);
+        static void run(Kind src_kind, Kind dst_kind, const void *src, void *dst, size_t n);
+
+        static void trim_mantissa(Kind kind, void *data, size_t n, int bits);
+    };
+
+}
+
+#endif
@@ -46,6 +46,17 @@
 #include "h5group.h"
 
 #include "h5datatype.h"
+#include "h5convert.h"
+#include "h5slab.h"
+#include "h5attribute.h"
+
+#include <cstring>
+#include <limits>
+#include <climits>
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
 
 namespace h5 {
 
@@ -57,16 +68,20 @@ namespace h5 {
     //
     // &operator<< should use filespace_dtype_
 
-    Dataset::Dataset():id_(-1), filespace_dtype_(-1), parent_(NULL) { }
+    Dataset::Dataset():id_(-1), filespace_dtype_(-1), parent_(NULL), append_buffer_records_(0), num_buffered_records_(0), chunk_cache_nslots_(0), chunk_cache_nbytes_(0), chunk_cache_w0_(0), statistics_bins_(-1), pyramid_levels_(0), significant_bits_(-1), hermitian_extent_(0), hermitian_reconstruction_(false), two_phase_(false), default_plan_(false) { }
 
     //Copy exesting dataset object
-    Dataset::Dataset(const Dataset& ds):name_(ds.name_), shape_(ds.shape_), filespace_dtype_(ds.filespace_dtype_), parent_(ds.parent_), driver_(ds.driver_), plan(ds.plan) {
+    //Records buffered by append() are not copied, they are written when the original is flushed
+    Dataset::Dataset(const Dataset& ds):name_(ds.name_), shape_(ds.shape_), filespace_dtype_(ds.filespace_dtype_), parent_(ds.parent_), driver_(ds.driver_), append_buffer_records_(ds.append_buffer_records_), num_buffered_records_(0), chunk_cache_nslots_(ds.chunk_cache_nslots_), chunk_cache_nbytes_(ds.chunk_cache_nbytes_), chunk_cache_w0_(ds.chunk_cache_w0_), statistics_bins_(ds.statistics_bins_), statistics_range_(ds.statistics_range_), index_block_(ds.index_block_), pyramid_levels_(ds.pyramid_levels_), pyramid_method_(ds.pyramid_method_), incremental_chunk_(ds.incremental_chunk_), significant_bits_(ds.significant_bits_), hermitian_extent_(ds.hermitian_extent_), hermitian_reconstruction_(ds.hermitian_reconstruction_), two_phase_(ds.two_phase_), default_plan_(ds.default_plan_), plan(ds.plan) {
 
 #ifdef H5SI_ENABLE_MPI
         this->MPI_COMMUNICATOR = this->parent_->MPI_COMMUNICATOR;
 #endif
 
-        this->id_ = H5Dopen2(this->parent_->id(), this->name_.c_str(), H5P_DEFAULT);
+        hid_t dapl = this->create_dapl();
+        this->id_ = H5Dopen2(this->parent_->id(), this->name_.c_str(), dapl);
+        if (dapl != H5P_DEFAULT)
+            H5Pclose(dapl);
 
         // this->parent_->register_node(*this);
     }
@@ -80,7 +95,9 @@ namespace h5 {
         hid_t space = H5Dget_space(this->id_);
         int nD = H5Sget_simple_extent_dims (space, NULL, NULL);
         this->shape_.resize(nD);
-        H5Sget_simple_extent_dims (space, shape_.data(), NULL);
+        std::vector<hsize_t> maxshape(nD);
+        H5Sget_simple_extent_dims (space, shape_.data(), maxshape.data());
+        H5Sclose(space);
 
         this->filespace_dtype_ = H5Dget_type(this->id_);
 
@@ -88,23 +105,45 @@ namespace h5 {
 
         this->driver_ = this->parent_->driver();
 
+        //Keep appending to an extendable dataset, buffering one chunk of records at a time
+        this->append_buffer_records_ = 0;
+        this->num_buffered_records_ = 0;
+
+        this->chunk_cache_nslots_ = 0;
+        this->chunk_cache_nbytes_ = 0;
+        this->chunk_cache_w0_ = 0;
+        this->statistics_bins_ = -1;
+        this->statistics_range_.clear();
+        this->pyramid_levels_ = 0;
+        this->significant_bits_ = -1;
+        this->hermitian_extent_ = 0;
+        this->hermitian_reconstruction_ = false;
+        this->two_phase_ = false;
+        this->default_plan_ = false;
+
+        if (has_attribute(this->id_, "hermitian_extent"))
+            read_attribute(this->id_, "hermitian_extent", H5T_NATIVE_HSIZE, &this->hermitian_extent_);
+
+        if (nD > 0 && maxshape[0] == H5S_UNLIMITED) {
+            std::vector<hsize_t> chunk(nD);
+            hid_t dcpl = H5Dget_create_plist(this->id_);
+            H5Pget_chunk(dcpl, nD, chunk.data());
+            H5Pclose(dcpl);
+
+            this->append_buffer_records_ = chunk[0];
+        }
+
 #ifdef H5SI_ENABLE_MPI
         this->MPI_COMMUNICATOR = this->parent_->MPI_COMMUNICATOR;
-
-        if (this->driver_ == "mpio")
-            this->plan.set_plan(this->MPI_COMMUNICATOR, this->shape_, Select::all(nD), this->shape_, Select::all(nD));  
-        else
-            this->plan.set_plan(this->shape_, Select::all(nD), this->shape_, Select::all(nD));      
-#else
-        this->plan.set_plan(this->shape_, Select::all(nD), this->shape_, Select::all(nD));      
 #endif
+        this->set_default_plan();
 
         // this->parent_->register_node(*this);
         
     }
 
     //Create a new dataset in file
-    Dataset::Dataset(Group *parent, std::string name, std::vector<hsize_t> shape, std::string filespace_dtype) {
+    Dataset::Dataset(Group *parent, std::string name, std::vector<hsize_t> shape, std::string filespace_dtype, DatasetOptions options) {
         this->name_ = parent->name() + "/" + name;
 
         this->shape_ = shape;
@@ -115,33 +154,52 @@ namespace h5 {
 
         this->driver_ = this->parent_->driver();
 
-        int nD = shape.size();
+        this->append_buffer_records_ = 0;
+        this->num_buffered_records_ = 0;
+
+        this->chunk_cache_nslots_ = 0;
+        this->chunk_cache_nbytes_ = 0;
+        this->chunk_cache_w0_ = 0;
+        this->statistics_bins_ = -1;
+        this->statistics_range_.clear();
+        this->pyramid_levels_ = 0;
+        this->significant_bits_ = -1;
+        this->hermitian_extent_ = 0;
+        this->hermitian_reconstruction_ = false;
+        this->two_phase_ = false;
+        this->default_plan_ = false;
+
+        //Half-spectrum, the last dimension is stored up to N/2
+        if (options.isHermitian() && !shape.empty()) {
+            this->hermitian_extent_ = shape.back();
+            this->shape_.back() = shape.back()/2 + 1;
+        }
+
 #ifdef H5SI_ENABLE_MPI
         this->MPI_COMMUNICATOR = this->parent_->MPI_COMMUNICATOR;
-
-
-        if (this->driver_ == "mpio") {
-            this->plan.set_plan(this->MPI_COMMUNICATOR, this->shape_, Select::all(nD), this->shape_, Select::all(nD));  
-        }
-        else
-            this->plan.set_plan(this->shape_, Select::all(nD), this->shape_, Select::all(nD));      
-#else
-        this->plan.set_plan(this->shape_, Select::all(nD), this->shape_, Select::all(nD));      
 #endif
+        this->set_default_plan();
+
+        hid_t dcpl = options.create_dcpl();
+        this->id_ = H5Dcreate2(this->parent_->id(), name.c_str(), Dtype(filespace_dtype), plan.filespace(), H5P_DEFAULT, dcpl, H5P_DEFAULT);
+        H5Pclose(dcpl);
 
-        this->id_ = H5Dcreate2(this->parent_->id(), name.c_str(), Dtype(filespace_dtype), plan.filespace(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+        if (this->hermitian_extent_ > 0)
+            write_attribute(this->id_, "hermitian_extent", H5T_NATIVE_HSIZE, &this->hermitian_extent_, 1);
 
         // this->parent_->register_node(*this);
     }
 
     //Create a new dataset according to the given plan in file
-    Dataset::Dataset(Group *parent, std::string name, Plan plan, std::string filespace_dtype) {
+    Dataset::Dataset(Group *parent, std::string name, Plan plan, std::string filespace_dtype, DatasetOptions options) {
         if (filespace_dtype.length() == 0)
             this->filespace_dtype_ = plan.dtype();
         else
             this->filespace_dtype_ = Dtype(filespace_dtype);
 
-        this->id_ = H5Dcreate2(parent->id(), name.c_str(), this->filespace_dtype_, plan.filespace(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+        hid_t dcpl = options.create_dcpl();
+        this->id_ = H5Dcreate2(parent->id(), name.c_str(), this->filespace_dtype_, plan.filespace(), H5P_DEFAULT, dcpl, H5P_DEFAULT);
+        H5Pclose(dcpl);
 
         if (this->id_ > 0) {
             this->name_ = parent->name() + "/" + name;
@@ -159,9 +217,117 @@ namespace h5 {
         this->parent_ = parent;
 
         this->driver_ = this->parent_->driver();
+
+        this->append_buffer_records_ = 0;
+        this->num_buffered_records_ = 0;
+
+        this->chunk_cache_nslots_ = 0;
+        this->chunk_cache_nbytes_ = 0;
+        this->chunk_cache_w0_ = 0;
+        this->statistics_bins_ = -1;
+        this->statistics_range_.clear();
+        this->pyramid_levels_ = 0;
+        this->significant_bits_ = -1;
+        this->hermitian_extent_ = 0;
+        this->hermitian_reconstruction_ = false;
+        this->two_phase_ = false;
+        this->default_plan_ = false;
+#ifdef H5SI_ENABLE_MPI
+        this->MPI_COMMUNICATOR = this->parent_->MPI_COMMUNICATOR;
+#endif
+    }
+
+    //Create a new extendable dataset in file
+    //Its shape is [0, record_shape...], the leading dimension is unlimited and grows with append().
+    //append() buffers 'buffer_records' records in memory and writes them with a single
+    //H5Dset_extent + H5Dwrite, which is also the chunk size along the leading dimension.
+    Dataset::Dataset(Group *parent, std::string name, std::vector<hsize_t> record_shape, std::string filespace_dtype, hsize_t buffer_records, DatasetOptions options) {
+        this->name_ = parent->name() + "/" + name;
+
+        this->filespace_dtype_ = Dtype(filespace_dtype);
+
+        this->parent_ = parent;
+
+        this->driver_ = this->parent_->driver();
+
+        this->append_buffer_records_ = (buffer_records > 0 ? buffer_records : 1);
+        this->num_buffered_records_ = 0;
+
+        this->chunk_cache_nslots_ = 0;
+        this->chunk_cache_nbytes_ = 0;
+        this->chunk_cache_w0_ = 0;
+        this->statistics_bins_ = -1;
+        this->statistics_range_.clear();
+        this->pyramid_levels_ = 0;
+        this->significant_bits_ = -1;
+        this->hermitian_extent_ = 0;
+        this->hermitian_reconstruction_ = false;
+        this->two_phase_ = false;
+        this->default_plan_ = false;
+
 #ifdef H5SI_ENABLE_MPI
         this->MPI_COMMUNICATOR = this->parent_->MPI_COMMUNICATOR;
 #endif
+
+        int nD = record_shape.size() + 1;
+
+        std::vector<hsize_t> maxshape(nD), chunk(nD);
+
+        this->shape_.resize(nD);
+        this->shape_[0] = 0;
+        maxshape[0] = H5S_UNLIMITED;
+        chunk[0] = this->append_buffer_records_;
+
+        for (int d=1; d<nD; d++)
+            this->shape_[d] = maxshape[d] = chunk[d] = record_shape[d-1];
+
+        hid_t space = H5Screate_simple(nD, this->shape_.data(), maxshape.data());
+
+        hid_t dcpl = options.create_dcpl();
+        H5Pset_chunk(dcpl, nD, chunk.data());
+
+        this->id_ = H5Dcreate2(this->parent_->id(), name.c_str(), this->filespace_dtype_, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+        H5Pclose(dcpl);
+        H5Sclose(space);
+
+        this->set_default_plan();
+
+        // this->parent_->register_node(*this);
+    }
+
+    //Plan covering the whole dataset, the leading dimension is divided among processes under mpio
+    //The memory of a half-spectrum holds the full last dimension, of which the stored half is selected.
+    //An empty extendable dataset gets its plan with the first records, see write_records(), later
+    //records update the plan's dataspaces in place.
+    void Dataset::set_default_plan() {
+        int nD = this->shape_.size();
+
+        this->default_plan_ = true;
+
+        if (nD == 0 || this->shape_[0] == 0)
+            return;
+
+        std::vector<hsize_t> memory_shape = this->shape_;
+        Select memory_select = Select::all(nD);
+
+        if (this->hermitian_extent_ > 0) {
+            memory_shape[nD-1] = this->hermitian_extent_;
+            memory_select[nD-1] = Range(0, this->shape_[nD-1]-1);
+        }
+
+        Plan plan;
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio")
+            plan.set_plan(this->MPI_COMMUNICATOR, memory_shape, memory_select, this->shape_, Select::all(nD));  
+        else
+            plan.set_plan(memory_shape, memory_select, this->shape_, Select::all(nD));      
+#else
+        plan.set_plan(memory_shape, memory_select, this->shape_, Select::all(nD));      
+#endif
+
+        this->plan.replace(plan);
     }
 
     void Dataset::create() {
@@ -173,13 +339,15 @@ namespace h5 {
     }
 
     void Dataset::close() {
-        if (this->id_ > 0)
+        if (this->id_ > 0) {
+            this->flush();
             H5Dclose(this->id_);
+            this->id_ = -1;
+        }
     }
 
     const Dataset &Dataset::operator=(const Dataset &dataset) {
-        if (this->id_ > 0)
-            H5Dclose(this->id_);
+        this->close();
 
         this->name_ = dataset.name_;
 
@@ -187,16 +355,41 @@ namespace h5 {
 
         this->driver_ = this->parent_->driver();
 
-        this->id_ = H5Dopen2(this->parent_->id(), this->name_.c_str(), H5P_DEFAULT);
+        this->chunk_cache_nslots_ = dataset.chunk_cache_nslots_;
+        this->chunk_cache_nbytes_ = dataset.chunk_cache_nbytes_;
+        this->chunk_cache_w0_ = dataset.chunk_cache_w0_;
+        this->statistics_bins_ = dataset.statistics_bins_;
+        this->statistics_range_ = dataset.statistics_range_;
+        this->index_block_ = dataset.index_block_;
+        this->pyramid_levels_ = dataset.pyramid_levels_;
+        this->pyramid_method_ = dataset.pyramid_method_;
+        this->incremental_chunk_ = dataset.incremental_chunk_;
+        this->significant_bits_ = dataset.significant_bits_;
+        this->hermitian_extent_ = dataset.hermitian_extent_;
+        this->hermitian_reconstruction_ = dataset.hermitian_reconstruction_;
+        this->two_phase_ = dataset.two_phase_;
+        this->default_plan_ = dataset.default_plan_;
+        this->hashed_box_.clear();
+        this->chunk_hashes_.clear();
+
+        hid_t dapl = this->create_dapl();
+        this->id_ = H5Dopen2(this->parent_->id(), this->name_.c_str(), dapl);
+        if (dapl != H5P_DEFAULT)
+            H5Pclose(dapl);
 
         this->shape_ = dataset.shape_;
 
         this->filespace_dtype_ = dataset.filespace_dtype_;
 
+        this->append_buffer_records_ = dataset.append_buffer_records_;
+        this->num_buffered_records_ = 0;
+
 #ifdef H5SI_ENABLE_MPI
         this->MPI_COMMUNICATOR = this->parent_->MPI_COMMUNICATOR;
 #endif
         this->plan = dataset.plan;
+
+        return *this;
     }
 
     hid_t Dataset::id() const { 
@@ -224,179 +417,2792 @@ namespace h5 {
     }
 
 
-    Dataset &Dataset::set_plan(Plan plan) {
-        this->plan = plan; return *this;
+    bool Dataset::isExtendable() const {
+        return (this->append_buffer_records_ > 0);
+    }
+
+    //Size in bytes of one record, i.e. one slice along the leading dimension, in native format
+    size_t Dataset::record_size() const {
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        size_t size = H5Tget_size(native_dtype);
+        H5Tclose(native_dtype);
+
+        for (std::vector<hsize_t>::size_type d=1; d<this->shape_.size(); d++)
+            size *= this->shape_[d];
+
+        return size;
+    }
+
+    //Whether the selection of a dataspace covers all of its elements
+    static bool isFullSelection(hid_t space) {
+        return (H5Sget_select_npoints(space) == H5Sget_simple_extent_npoints(space));
+    }
+
+    static void Reduce_selection(hid_t memoryspace, hid_t dtype, const void *data, Reduction &reduction);
+
+    //Moments and, if bins are set, the histogram of the write statistics, fed by one pass
+    class Statistics_ : public Reduction
+    {
+        Moments &moments_;
+        Histogram *histogram_;
+
+    public:
+        Statistics_(Moments &moments, Histogram *histogram): moments_(moments), histogram_(histogram) { }
+
+        void accumulate(const double *data, size_t n) {
+            this->moments_.accumulate(data, n);
+            if (this->histogram_ != NULL)
+                this->histogram_->accumulate(data, n);
+        }
+
+#ifdef H5SI_ENABLE_MPI
+        void combine(MPI_Comm comm) {
+            this->moments_.combine(comm);
+            if (this->histogram_ != NULL)
+                this->histogram_->combine(comm);
+        }
+#endif
+    };
+
+    //Feed n values of kind, of size bytes each, to reduction, converted to double in cache sized blocks
+    static void Accumulate_values_(Convert::Kind kind, size_t size, const void *data, size_t n, Reduction &reduction) {
+        const size_t block_size = 4096;
+        double values[block_size];
+        const char *bytes = static_cast<const char*>(data);
+
+        for (size_t i=0; i<n; i+=block_size) {
+            size_t m = std::min(block_size, n-i);
+
+            if (kind == Convert::DOUBLE)
+                reduction.accumulate(reinterpret_cast<const double*>(bytes + i*size), m);
+            else {
+                Convert::run(kind, Convert::DOUBLE, bytes + i*size, values, m);
+                reduction.accumulate(values, m);
+            }
+        }
+    }
+
+    //Source of H5Dscatter(), the whole received buffer at once
+    struct Scatter_source_ {
+        const void *buffer;
+        size_t size;
+    };
+
+    static herr_t Scatter_source_callback_(const void **src_buf, size_t *src_buf_bytes_used, void *op_data) {
+        Scatter_source_ *source = static_cast<Scatter_source_*>(op_data);
+
+        *src_buf = source->buffer;
+        *src_buf_bytes_used = source->size;
+        return 0;
+    }
+
+    //Conversion, rounding and statistics of elements staged block by block, in packed order
+    struct Stage_ {
+        Convert::Kind src_kind, dst_kind;
+        size_t src_size, dst_size;
+        bool convert;
+        int significant_bits;           // Mantissa bits kept, -1 for all
+        Reduction *statistics;          // Fed the staged values, NULL for none
+        const char *src;                // Next packed element to unpack, see Unstage_callback_()
+        hsize_t remaining;
+        char *dst;                      // Next packed element to stage, see Stage_block_()
+        std::vector<char> block;
+
+        Stage_(hid_t src_dtype, hid_t dst_dtype, int significant_bits, Reduction *statistics):
+            src_kind(Convert::kind(src_dtype)), dst_kind(Convert::kind(dst_dtype)), src_size(H5Tget_size(src_dtype)), dst_size(H5Tget_size(dst_dtype)),
+            convert(H5Tequal(src_dtype, dst_dtype) <= 0), significant_bits(significant_bits), statistics(statistics), src(NULL), remaining(0), dst(NULL) { }
+    };
+
+    static const size_t Stage_block_size_ = 4096;
+
+    //Stage n elements of src at stage.dst, converted, rounded and counted while in cache
+    static void Stage_block_(Stage_ &stage, const void *src, size_t n) {
+        if (stage.convert)
+            Convert::run(stage.src_kind, stage.dst_kind, src, stage.dst, n);
+        else
+            memcpy(stage.dst, src, n*stage.dst_size);
+
+        if (stage.significant_bits >= 0)
+            Convert::trim_mantissa(stage.dst_kind, stage.dst, n, stage.significant_bits);
+
+        if (stage.statistics != NULL)
+            Accumulate_values_(stage.dst_kind, stage.dst_size, stage.dst, n, *stage.statistics);
+
+        stage.dst += n*stage.dst_size;
+    }
+
+    static herr_t Stage_callback_(const void *dst_buf, size_t dst_buf_bytes_used, void *op_data) {
+        Stage_ *stage = static_cast<Stage_*>(op_data);
+        Stage_block_(*stage, dst_buf, dst_buf_bytes_used/stage->src_size);
+        return 0;
+    }
+
+    //Stage the selected elements of src, laid out as memoryspace, packed at stage.dst, gathered
+    //block by block with H5Dgather
+    static herr_t Stage_selection_(Stage_ &stage, hid_t src_dtype, hid_t memoryspace, const void *src) {
+        if (H5Sget_select_npoints(memoryspace) == 0)
+            return 0;
+
+        stage.block.resize(Stage_block_size_*stage.src_size);
+        return H5Dgather(memoryspace, src, src_dtype, stage.block.size(), stage.block.data(), Stage_callback_, &stage);
+    }
+
+    //Source of H5Dscatter(), the next block of the packed elements at stage.src, converted
+    static herr_t Unstage_callback_(const void **src_buf, size_t *src_buf_bytes_used, void *op_data) {
+        Stage_ *stage = static_cast<Stage_*>(op_data);
+        size_t n = std::min(hsize_t(Stage_block_size_), stage->remaining);
+
+        stage->block.resize(Stage_block_size_*stage->dst_size);
+        stage->dst = stage->block.data();
+        Stage_block_(*stage, stage->src, n);
+
+        stage->src += n*stage->src_size;
+        stage->remaining -= n;
+
+        *src_buf = stage->block.data();
+        *src_buf_bytes_used = n*stage->dst_size;
+        return 0;
+    }
+
+    //Place the packed elements of stage.src, converted, at the selection of memoryspace in dst
+    static herr_t Unstage_selection_(Stage_ &stage, hid_t dst_dtype, hid_t memoryspace, void *dst) {
+        stage.remaining = H5Sget_select_npoints(memoryspace);
+
+        if (stage.remaining == 0)
+            return 0;
+
+        return H5Dscatter(Unstage_callback_, &stage, dst_dtype, memoryspace, dst);
+    }
+
+    //Read the plan's selection into data, held in memory datatype dtype, see read(dtype, memoryspace, filespace, data)
+    //The redundant half of a half-spectrum is filled in if set_hermitian_reconstruction() is on.
+    herr_t Dataset::read(hid_t dtype, void *data) const {
+        herr_t status = this->read(dtype, this->plan.memoryspace(), this->plan.filespace(), data);
+
+        if (status >= 0 && this->hermitian_reconstruction_)
+            this->reconstruct_hermitian(dtype, data);
+
+        return status;
+    }
+
+    //Write data, held in memory datatype dtype, to the plan's selection
+    //When dtype differs from the dataset's datatype and the conversion is supported by Convert,
+    //data is converted to the dataset's native datatype in a staging buffer which is written.
+    //The staging buffer is kept for subsequent transfers, and laid out as the memoryspace; a
+    //partial selection is packed with H5Dgather, staged, and placed there with H5Dscatter.
+    //Floating point data is rounded to the significant bits, if set, before it is written.
+    //Conversion, rounding and the statistics of set_statistics() go block by block in one pass,
+    //each block is counted right after it is staged, while it is in cache. Without staging the
+    //statistics make the only pass over the memory selection.
+    //The min/max index and pyramid levels are updated from the values stored, after conversion and
+    //rounding, see set_minmax_index() and set_pyramid().
+    herr_t Dataset::write(hid_t dtype, const void *data) const {
+        hid_t memoryspace = this->plan.memoryspace();
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        herr_t status;
+
+        //Incremental writes narrow the selections to the chunks that changed since the last write
+        hid_t changed_memoryspace = memoryspace;
+        hid_t changed_filespace = this->plan.filespace();
+        bool incremental = this->select_changed_chunks(dtype, data, changed_memoryspace, changed_filespace);
+
+        const void *buffer = data;
+        hid_t buffer_dtype = dtype;
+        size_t n = H5Sget_simple_extent_npoints(memoryspace);
+
+        bool convert = (H5Tequal(dtype, native_dtype) <= 0 && Convert::isSupported(dtype, native_dtype));
+
+        if (convert)
+            buffer_dtype = native_dtype;
+
+        //Round away the insignificant mantissa bits, on a copy when the caller's data is written
+        Convert::Kind buffer_kind = Convert::kind(buffer_dtype);
+        bool trim = (this->significant_bits_ >= 0 && (buffer_kind == Convert::FLOAT || buffer_kind == Convert::DOUBLE));
+
+        Moments moments;
+        Histogram histogram(this->statistics_range_.empty() ? 0 : this->statistics_range_[0], this->statistics_range_.empty() ? 0 : this->statistics_range_[1], this->statistics_bins_);
+        Statistics_ statistics(moments, this->statistics_bins_ > 0 ? &histogram : NULL);
+        bool has_statistics = (this->statistics_bins_ >= 0 && buffer_kind != Convert::NONE);
+        bool statistics_done = false;
+
+        if (convert || trim) {
+            size_t dst_size = H5Tget_size(buffer_dtype);
+
+            if (this->staging_.size() < n*dst_size)
+                this->staging_.resize(n*dst_size);
+
+            Stage_ stage(dtype, buffer_dtype, trim ? this->significant_bits_ : -1, has_statistics ? &statistics : NULL);
+
+            if (isFullSelection(memoryspace)) {
+                stage.dst = this->staging_.data();
+                for (size_t i=0; i<n; i+=Stage_block_size_)
+                    Stage_block_(stage, static_cast<const char*>(data) + i*stage.src_size, std::min(Stage_block_size_, n-i));
+            }
+            else {
+                std::vector<char> packed(H5Sget_select_npoints(memoryspace)*dst_size);
+                stage.dst = packed.data();
+                Stage_selection_(stage, dtype, memoryspace, data);
+
+                Scatter_source_ source = {packed.data(), packed.size()};
+                if (!packed.empty())
+                    H5Dscatter(Scatter_source_callback_, &source, buffer_dtype, memoryspace, this->staging_.data());
+            }
+
+            buffer = this->staging_.data();
+            statistics_done = true;
+        }
+
+        if (has_statistics && !statistics_done)
+            Reduce_selection(memoryspace, buffer_dtype, buffer, statistics);
+
+        status = this->transfer(true, buffer_dtype, changed_memoryspace, changed_filespace, const_cast<void*>(buffer));
+
+        if (incremental) {
+            H5Sclose(changed_memoryspace);
+            H5Sclose(changed_filespace);
+        }
+
+        if (has_statistics)
+            this->store_statistics(moments, histogram, status);
+
+        //From the values stored, converted and rounded
+        this->update_minmax_index(buffer_dtype, memoryspace, buffer);
+        this->update_pyramid(buffer_dtype, memoryspace, buffer);
+
+        H5Tclose(native_dtype);
+        return status;
+    }
+
+    //MPI-IO counts are ints, HDF5 1.8 fails on larger transfers
+    size_t Dataset::max_transfer_size_ = 2147483647;
+
+    //Bytes moved by one H5Dread/H5Dwrite at most, larger transfers are split
+    void Dataset::set_max_transfer_size(size_t bytes) {
+        Dataset::max_transfer_size_ = (bytes > 0 ? bytes : 1);
+    }
+
+    //H5Dread of the given selections, split as needed, see transfer(), or two-phase, see set_two_phase()
+    //When dtype differs from the dataset's datatype and the conversion is supported by Convert,
+    //the selection is read in the native datatype, packed into the staging buffer, and converted
+    //from there into data with H5Dscatter.
+    herr_t Dataset::read(hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const {
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        herr_t status;
+
+        if (H5Tequal(dtype, native_dtype) <= 0 && Convert::isSupported(native_dtype, dtype)) {
+            //A full selection is packed already
+            bool is_full = isFullSelection(memoryspace);
+            hsize_t n = H5Sget_select_npoints(memoryspace);
+            hid_t staged_space = (is_full ? memoryspace : H5Screate_simple(1, &n, NULL));
+
+            if (this->staging_.size() < n*H5Tget_size(native_dtype))
+                this->staging_.resize(n*H5Tget_size(native_dtype));
+
+            status = this->read_selection(native_dtype, staged_space, filespace, this->staging_.data());
+
+            Stage_ stage(native_dtype, dtype, -1, NULL);
+            stage.src = this->staging_.data();
+
+            if (status >= 0 && is_full) {
+                stage.dst = static_cast<char*>(data);
+                for (hsize_t i=0; i<n; i+=Stage_block_size_)
+                    Stage_block_(stage, stage.src + i*stage.src_size, std::min(hsize_t(Stage_block_size_), n-i));
+            }
+            else if (status >= 0)
+                status = Unstage_selection_(stage, dtype, memoryspace, data);
+
+            if (!is_full)
+                H5Sclose(staged_space);
+        }
+        else
+            status = this->read_selection(dtype, memoryspace, filespace, data);
+
+        H5Tclose(native_dtype);
+        return status;
+    }
+
+    //H5Dwrite of the given selections, split as needed, see transfer()
+    //Data is converted as by write(dtype, data), packed into the staging buffer with H5Dgather.
+    //The statistics of set_statistics() are taken from the memory selection. Datasets with other
+    //write-time features, see write_hooks(), are refused as these need the plan's selections.
+    herr_t Dataset::write(hid_t dtype, hid_t memoryspace, hid_t filespace, const void *data) const {
+        std::string hooks = this->write_hooks(false);
+        if (!hooks.empty()) {
+            std::cerr << "Dataset::write: " << this->name_ << " has " << hooks << ", which a write of explicit selections does not update, use write(dtype, data)" << std::endl;
+            return -1;
+        }
+
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        herr_t status;
+
+        if (H5Tequal(dtype, native_dtype) <= 0 && Convert::isSupported(dtype, native_dtype)) {
+            //A full selection is packed already
+            bool is_full = isFullSelection(memoryspace);
+            hsize_t n = H5Sget_select_npoints(memoryspace);
+            hid_t staged_space = (is_full ? memoryspace : H5Screate_simple(1, &n, NULL));
+
+            if (this->staging_.size() < n*H5Tget_size(native_dtype))
+                this->staging_.resize(n*H5Tget_size(native_dtype));
+
+            Stage_ stage(dtype, native_dtype, -1, NULL);
+            stage.dst = this->staging_.data();
+            status = 0;
+
+            if (is_full) {
+                for (hsize_t i=0; i<n; i+=Stage_block_size_)
+                    Stage_block_(stage, static_cast<const char*>(data) + i*stage.src_size, std::min(hsize_t(Stage_block_size_), n-i));
+            }
+            else
+                status = Stage_selection_(stage, dtype, memoryspace, data);
+
+            if (status >= 0)
+                status = this->transfer(true, native_dtype, staged_space, filespace, this->staging_.data());
+
+            this->update_statistics(native_dtype, staged_space, this->staging_.data(), status);
+
+            if (!is_full)
+                H5Sclose(staged_space);
+        }
+        else {
+            status = this->transfer(true, dtype, memoryspace, filespace, const_cast<void*>(data));
+            this->update_statistics(dtype, memoryspace, data, status);
+        }
+
+        H5Tclose(native_dtype);
+        return status;
+    }
+
+    //Call f(start, end) for each block of a hyperslab selection, or for the whole extent if all is
+    //selected, start and end the first and last corners. Returns false for point selections.
+    template<typename F>
+    static bool For_each_block_(hid_t space, F &f) {
+        int nD = H5Sget_simple_extent_ndims(space);
+        std::vector<hsize_t> dims(nD);
+        H5Sget_simple_extent_dims(space, dims.data(), NULL);
+
+        switch (H5Sget_select_type(space)) {
+            case H5S_SEL_NONE:
+                return true;
+
+            case H5S_SEL_ALL: {
+                std::vector<hsize_t> start(nD, 0), end(nD);
+                for (int d=0; d<nD; d++)
+                    end[d] = dims[d]-1;
+                if (H5Sget_simple_extent_npoints(space) > 0)
+                    f(start.data(), end.data());
+                return true;
+            }
+
+            case H5S_SEL_HYPERSLABS: {
+                const hsize_t batch = 4096;
+                hsize_t num_blocks = H5Sget_select_hyper_nblocks(space);
+                std::vector<hsize_t> blocks(2*nD*batch);
+
+                for (hsize_t b=0; b<num_blocks; b+=batch) {
+                    hsize_t n = std::min(batch, num_blocks - b);
+                    H5Sget_select_hyper_blocklist(space, b, n, blocks.data());
+
+                    for (hsize_t k=0; k<n; k++)
+                        f(&blocks[2*nD*k], &blocks[2*nD*k + nD]);
+                }
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    //Adds the selected elements of each block to the rows of the leading dimension it covers
+    struct Row_counter_ {
+        int nD;
+        std::vector<hsize_t> &counts;
+
+        Row_counter_(int nD, std::vector<hsize_t> &counts):nD(nD), counts(counts) { }
+
+        void operator()(const hsize_t *start, const hsize_t *end) {
+            hsize_t per_row = 1;
+            for (int d=1; d<nD; d++)
+                per_row *= end[d] - start[d] + 1;
+
+            for (hsize_t r=start[0]; r<=end[0]; r++)
+                counts[r] += per_row;
+        }
+    };
+
+    //ORs the part of each block of a 1-D selection that falls in [begin, end) of its selected elements
+    struct Element_selector_ {
+        hid_t part;
+        hsize_t begin, end, seen;
+
+        Element_selector_(hid_t part, hsize_t begin, hsize_t end):part(part), begin(begin), end(end), seen(0) { }
+
+        void operator()(const hsize_t *start, const hsize_t *last) {
+            hsize_t n = last[0] - start[0] + 1;
+            hsize_t first = std::max(this->begin, this->seen), stop = std::min(this->end, this->seen + n);
+
+            if (first < stop) {
+                hsize_t offset = start[0] + first - this->seen, count = stop - first;
+                H5Sselect_hyperslab(this->part, H5S_SELECT_OR, &offset, NULL, &count, NULL);
+            }
+
+            this->seen += n;
+        }
+    };
+
+    //Cumulative count of selected elements before each row of the leading dimension, rows+1 values.
+    //Empty for 1-D spaces, which can be split after any element. False if the selection can not be split.
+    static bool Cumulative_row_counts_(hid_t space, std::vector<hsize_t> &cumulative) {
+        int nD = H5Sget_simple_extent_ndims(space);
+        cumulative.clear();
+
+        if (nD <= 0)
+            return false;
+
+        if (nD == 1)
+            return (H5Sget_select_type(space) != H5S_SEL_POINTS);
+
+        std::vector<hsize_t> dims(nD), counts;
+        H5Sget_simple_extent_dims(space, dims.data(), NULL);
+        counts.assign(dims[0], 0);
+
+        Row_counter_ counter(nD, counts);
+        if (!For_each_block_(space, counter))
+            return false;
+
+        cumulative.assign(dims[0]+1, 0);
+        for (hsize_t r=0; r<dims[0]; r++)
+            cumulative[r+1] = cumulative[r] + counts[r];
+
+        return true;
+    }
+
+    //Copy of space selecting only the elements [begin, end) of its selection, which must fall on row
+    //boundaries unless space is 1-D
+    static hid_t Select_part_(hid_t space, const std::vector<hsize_t> &cumulative, hsize_t begin, hsize_t end) {
+        hid_t part = H5Scopy(space);
+
+        if (cumulative.empty()) {
+            H5Sselect_none(part);
+            Element_selector_ selector(part, begin, end);
+            For_each_block_(space, selector);
+            return part;
+        }
+
+        int nD = H5Sget_simple_extent_ndims(space);
+        std::vector<hsize_t> start(nD, 0), count(nD);
+        H5Sget_simple_extent_dims(space, count.data(), NULL);
+
+        //Rows [first, last) holding elements [begin, end), trailing empty rows go to the next part
+        start[0] = std::upper_bound(cumulative.begin(), cumulative.end(), begin) - cumulative.begin() - 1;
+        count[0] = (std::lower_bound(cumulative.begin(), cumulative.end(), end) - cumulative.begin()) - start[0];
+
+        H5Sselect_hyperslab(part, H5S_SELECT_AND, start.data(), NULL, count.data(), NULL);
+        return part;
+    }
+
+    /**
+     * H5Dread or H5Dwrite of the selections, split into several transfers of at most
+     * set_max_transfer_size() bytes each, 2^31-1 by default, as MPI-IO takes int counts.
+     * The selections are split where both have moved the same number of elements after whole
+     * rows of the leading dimension, or after any element of a 1-D selection. A part larger than
+     * the limit is transferred as a whole if there is no such split point in between. The
+     * transfers are independent, processes need not split into the same number of parts.
+     */
+    herr_t Dataset::transfer(bool is_write, hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const {
+        return Dataset::transfer(this->id_, H5P_DEFAULT, is_write, dtype, memoryspace, filespace, data);
+    }
+
+    //Bytes of one element of a transfer, the larger of the memory and the file datatype
+    static size_t Transfer_element_size_(hid_t dataset, hid_t dtype) {
+        hid_t file_dtype = H5Dget_type(dataset);
+        size_t element_size = std::max(H5Tget_size(dtype), H5Tget_size(file_dtype));
+        H5Tclose(file_dtype);
+        return element_size;
+    }
+
+    //Whether a transfer of the memory selection stays within set_max_transfer_size(), and is not split
+    bool Dataset::fits_transfer(hid_t dataset, hid_t dtype, hid_t memoryspace) {
+        hsize_t n = H5Sget_select_npoints(memoryspace);
+        return n <= std::max(Dataset::max_transfer_size_/Transfer_element_size_(dataset, dtype), size_t(1));
+    }
+
+    //transfer() of any dataset with the transfer property list dxpl. Under collective transfers
+    //all processes must split into the same number of parts, see fits_transfer().
+    herr_t Dataset::transfer(hid_t dataset, hid_t dxpl, bool is_write, hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) {
+        hsize_t n = H5Sget_select_npoints(memoryspace);
+        hsize_t max_elements = std::max(Dataset::max_transfer_size_/Transfer_element_size_(dataset, dtype), size_t(1));
+
+        std::vector<hsize_t> memory_cumulative, file_cumulative;
+
+        if (n <= max_elements || !Cumulative_row_counts_(memoryspace, memory_cumulative) || !Cumulative_row_counts_(filespace, file_cumulative)) {
+            if (is_write)
+                return H5Dwrite(dataset, dtype, memoryspace, filespace, dxpl, data);
+            else
+                return H5Dread(dataset, dtype, memoryspace, filespace, dxpl, data);
+        }
+
+        //Element counts at which both selections can be split
+        std::vector<hsize_t> splits;
+
+        if (memory_cumulative.empty() && file_cumulative.empty()) {
+            for (hsize_t c=max_elements; c<n; c+=max_elements)
+                splits.push_back(c);
+        }
+        else if (memory_cumulative.empty())
+            splits = file_cumulative;
+        else if (file_cumulative.empty())
+            splits = memory_cumulative;
+        else
+            std::set_intersection(memory_cumulative.begin(), memory_cumulative.end(), file_cumulative.begin(), file_cumulative.end(), std::back_inserter(splits));
+
+        splits.push_back(n);
+
+        herr_t status = 0;
+        hsize_t done = 0;
+        std::vector<hsize_t>::size_type i = 0;
+
+        while (done < n) {
+            //Furthest split within the limit, or the nearest one beyond it
+            hsize_t end = 0;
+            for (; i<splits.size() && (end <= done || splits[i] - done <= max_elements); i++)
+                if (splits[i] > done)
+                    end = splits[i];
+
+            hid_t memory_part = Select_part_(memoryspace, memory_cumulative, done, end);
+            hid_t file_part = Select_part_(filespace, file_cumulative, done, end);
+
+            herr_t part_status;
+            if (is_write)
+                part_status = H5Dwrite(dataset, dtype, memory_part, file_part, dxpl, data);
+            else
+                part_status = H5Dread(dataset, dtype, memory_part, file_part, dxpl, data);
+
+            if (part_status < 0)
+                status = part_status;
+
+            H5Sclose(memory_part);
+            H5Sclose(file_part);
+
+            done = end;
+        }
+
+        return status;
+    }
+
+    //Reads of many short file runs are redistributed under mpio
+    size_t Dataset::two_phase_run_size_ = 65536;
+
+    //Mean contiguous file run in bytes below which reads of datasets with set_two_phase() are two-phase, 0 to never redistribute
+    void Dataset::set_two_phase_run_size(size_t bytes) {
+        Dataset::two_phase_run_size_ = bytes;
+    }
+
+    /**
+     * Let reads of this dataset be two-phase under mpio when the processes read it in short file
+     * runs, see prefers_two_phase() and read_two_phase(). Every read, with read() or operator>>,
+     * is then collective: all processes of the communicator must make it, with their own
+     * selections. Off by default, reads are independent and any subset of processes may read.
+     */
+    Dataset &Dataset::set_two_phase(bool two_phase) {
+        this->two_phase_ = two_phase;
+        return *this;
+    }
+
+    //Read of the given selections, two-phase when set_two_phase() is on and prefers_two_phase(), else with transfer()
+    herr_t Dataset::read_selection(hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const {
+        if (this->two_phase_ && this->prefers_two_phase(dtype, filespace))
+            return this->read_two_phase(dtype, memoryspace, filespace, data);
+
+        return this->transfer(false, dtype, memoryspace, filespace, data);
+    }
+
+#ifdef H5SI_ENABLE_MPI
+    //Contiguous runs of the linear file order covered by the selection of space, adjacent blocks counted apart
+    static hsize_t Count_file_runs_(hid_t space) {
+        switch (H5Sget_select_type(space)) {
+            case H5S_SEL_NONE: return 0;
+            case H5S_SEL_ALL: return 1;
+            case H5S_SEL_HYPERSLABS: break;
+            default: return H5Sget_select_npoints(space);
+        }
+
+        int nD = H5Sget_simple_extent_ndims(space);
+        std::vector<hsize_t> dims(nD);
+        H5Sget_simple_extent_dims(space, dims.data(), NULL);
+
+        hssize_t nblocks = H5Sget_select_hyper_nblocks(space);
+        std::vector<hsize_t> blocks(2*nD*std::max(nblocks, hssize_t(0)));
+        H5Sget_select_hyper_blocklist(space, 0, nblocks, blocks.data());
+
+        hsize_t runs = 0;
+
+        for (hssize_t b=0; b<nblocks; b++) {
+            const hsize_t *start = &blocks[2*nD*b];
+            const hsize_t *end = start + nD;
+
+            //Trailing dimensions the block spans fully are contiguous with the first one it does not
+            int j = nD-1;
+            while (j > 0 && start[j] == 0 && end[j] == dims[j]-1)
+                j--;
+
+            hsize_t n = 1;
+            for (int d=0; d<j; d++)
+                n *= end[d] - start[d] + 1;
+
+            runs += n;
+        }
+
+        return runs;
+    }
+
+    //Bytes moved in and out of a process by one round of Alltoallv_large_() at most
+    static const unsigned long long Alltoallv_round_bytes_ = 268435456;
+
+    /**
+     * MPI_Alltoallv of elements of 'size' bytes with 64-bit counts and offsets, in elements.
+     * When every process sends and receives fewer than 2^31 elements it is a single MPI_Alltoallv,
+     * else the elements between each pair of processes go in rounds, packed into buffers of
+     * Alltoallv_round_bytes_ at most whose int counts and offsets can not overflow. Collective.
+     */
+    static void Alltoallv_large_(const char *send, const std::vector<unsigned long long> &send_counts, const std::vector<unsigned long long> &send_offsets,
+                                 char *receive, const std::vector<unsigned long long> &receive_counts, const std::vector<unsigned long long> &receive_offsets,
+                                 size_t size, MPI_Comm comm) {
+        int numprocs = send_counts.size();
+
+        MPI_Datatype element;
+        MPI_Type_contiguous(size, MPI_BYTE, &element);
+        MPI_Type_commit(&element);
+
+        int fits = (send_offsets[numprocs-1] + send_counts[numprocs-1] <= INT_MAX && receive_offsets[numprocs-1] + receive_counts[numprocs-1] <= INT_MAX);
+        MPI_Allreduce(MPI_IN_PLACE, &fits, 1, MPI_INT, MPI_MIN, comm);
+
+        std::vector<int> round_send_counts(numprocs), round_send_offsets(numprocs), round_receive_counts(numprocs), round_receive_offsets(numprocs);
+
+        if (fits) {
+            for (int r=0; r<numprocs; r++) {
+                round_send_counts[r] = send_counts[r];
+                round_send_offsets[r] = send_offsets[r];
+                round_receive_counts[r] = receive_counts[r];
+                round_receive_offsets[r] = receive_offsets[r];
+            }
+
+            MPI_Alltoallv(const_cast<char*>(send), round_send_counts.data(), round_send_offsets.data(), element,
+                          receive, round_receive_counts.data(), round_receive_offsets.data(), element, comm);
+
+            MPI_Type_free(&element);
+            return;
+        }
+
+        //Elements between a pair of processes in one round
+        unsigned long long per_pair = std::max(Alltoallv_round_bytes_/size/numprocs, 1ULL);
+
+        unsigned long long max_count = 0;
+        for (int r=0; r<numprocs; r++)
+            max_count = std::max(max_count, std::max(send_counts[r], receive_counts[r]));
+        MPI_Allreduce(MPI_IN_PLACE, &max_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, comm);
+
+        std::vector<char> round_send(per_pair*numprocs*size), round_receive(per_pair*numprocs*size);
+
+        for (unsigned long long done=0; done<max_count; done+=per_pair) {
+            int send_offset = 0, receive_offset = 0;
+
+            for (int r=0; r<numprocs; r++) {
+                unsigned long long n = (send_counts[r] > done ? std::min(per_pair, send_counts[r] - done) : 0);
+                memcpy(&round_send[size_t(send_offset)*size], send + (send_offsets[r] + done)*size, n*size);
+                round_send_counts[r] = n;
+                round_send_offsets[r] = send_offset;
+                send_offset += n;
+
+                n = (receive_counts[r] > done ? std::min(per_pair, receive_counts[r] - done) : 0);
+                round_receive_counts[r] = n;
+                round_receive_offsets[r] = receive_offset;
+                receive_offset += n;
+            }
+
+            MPI_Alltoallv(round_send.data(), round_send_counts.data(), round_send_offsets.data(), element,
+                          round_receive.data(), round_receive_counts.data(), round_receive_offsets.data(), element, comm);
+
+            for (int r=0; r<numprocs; r++)
+                memcpy(receive + (receive_offsets[r] + done)*size, &round_receive[size_t(round_receive_offsets[r])*size], size_t(round_receive_counts[r])*size);
+        }
+
+        MPI_Type_free(&element);
+    }
+#endif
+
+    /**
+     * Whether the processes together read the dataset in file runs shorter on average than
+     * set_two_phase_run_size(), such as z-pencils of x-slab written data, and cover all of it.
+     * Only under mpio with more than one process. Collective, all processes get the same answer,
+     * so it is only asked for datasets with set_two_phase().
+     */
+    bool Dataset::prefers_two_phase(hid_t dtype, hid_t filespace) const {
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ != "mpio" || Dataset::two_phase_run_size_ == 0 || H5Sget_simple_extent_ndims(filespace) < 1)
+            return false;
+
+        int numprocs;
+        MPI_Comm_size(this->MPI_COMMUNICATOR, &numprocs);
+
+        if (numprocs < 2)
+            return false;
+
+        double local[2] = {double(H5Sget_select_npoints(filespace)), double(Count_file_runs_(filespace))};
+        double total[2];
+        MPI_Allreduce(local, total, 2, MPI_DOUBLE, MPI_SUM, this->MPI_COMMUNICATOR);
+
+        //The slabs of the first phase hold the whole dataset, not worth it for a part of it
+        if (total[0] < double(H5Sget_simple_extent_npoints(filespace)))
+            return false;
+
+        return total[0]*H5Tget_size(dtype) < total[1]*Dataset::two_phase_run_size_;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Two-phase read: each process reads an even share of the rows of the leading dimension as
+     * one contiguous slab, then the elements are sent with MPI_Alltoallv to the processes whose
+     * file selections hold them. The selections are exchanged encoded with H5Sencode. A process
+     * receives the elements of its selection in the linear file order, slab after slab, which is
+     * the order H5Dread fills the memory selection in, and scatters them there with H5Dscatter.
+     */
+    herr_t Dataset::read_two_phase(hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const {
+#ifdef H5SI_ENABLE_MPI
+        MPI_Comm comm = this->MPI_COMMUNICATOR;
+        int my_id, numprocs;
+        MPI_Comm_rank(comm, &my_id);
+        MPI_Comm_size(comm, &numprocs);
+
+        size_t size = H5Tget_size(dtype);
+        int nD = H5Sget_simple_extent_ndims(filespace);
+        std::vector<hsize_t> dims(nD);
+        H5Sget_simple_extent_dims(filespace, dims.data(), NULL);
+
+        //First phase, rows [first, first+rows) of the leading dimension
+        std::vector<hsize_t> slab_start(nD, 0), slab_count = dims;
+        slab_start[0] = my_id*dims[0]/numprocs;
+        slab_count[0] = (my_id+1)*dims[0]/numprocs - slab_start[0];
+
+        hsize_t slab_elements = 1;
+        for (int d=0; d<nD; d++)
+            slab_elements *= slab_count[d];
+
+        std::vector<char> slab(slab_elements*size);
+        herr_t status = 0;
+
+        if (slab_elements > 0) {
+            hid_t slab_memoryspace = H5Screate_simple(nD, slab_count.data(), NULL);
+            hid_t slab_filespace = H5Scopy(filespace);
+            H5Sselect_hyperslab(slab_filespace, H5S_SELECT_SET, slab_start.data(), NULL, slab_count.data(), NULL);
+
+            status = this->transfer(false, dtype, slab_memoryspace, slab_filespace, slab.data());
+
+            H5Sclose(slab_memoryspace);
+            H5Sclose(slab_filespace);
+        }
+
+        //Selections of all processes
+        size_t encoded_size = 0;
+        H5Sencode(filespace, NULL, &encoded_size);
+        std::vector<unsigned char> encoded(encoded_size);
+        H5Sencode(filespace, encoded.data(), &encoded_size);
+
+        //Sent to every process, as the same encoding is its part of the send buffer for each
+        unsigned long long my_encoded_size = encoded_size;
+        std::vector<unsigned long long> encoded_sizes(numprocs), encoded_offsets(numprocs, 0);
+        MPI_Allgather(&my_encoded_size, 1, MPI_UNSIGNED_LONG_LONG, encoded_sizes.data(), 1, MPI_UNSIGNED_LONG_LONG, comm);
+
+        for (int r=1; r<numprocs; r++)
+            encoded_offsets[r] = encoded_offsets[r-1] + encoded_sizes[r-1];
+
+        std::vector<unsigned char> all_encoded(encoded_offsets[numprocs-1] + encoded_sizes[numprocs-1]);
+
+        if (encoded_offsets[numprocs-1] + encoded_sizes[numprocs-1] <= INT_MAX) {
+            std::vector<int> sizes(encoded_sizes.begin(), encoded_sizes.end()), offsets(encoded_offsets.begin(), encoded_offsets.end());
+            MPI_Allgatherv(encoded.data(), my_encoded_size, MPI_BYTE, all_encoded.data(), sizes.data(), offsets.data(), MPI_BYTE, comm);
+        }
+        else {
+            memcpy(&all_encoded[encoded_offsets[my_id]], encoded.data(), my_encoded_size);
+
+            for (int r=0; r<numprocs; r++)
+                for (unsigned long long done=0; done<encoded_sizes[r]; done+=INT_MAX)
+                    MPI_Bcast(&all_encoded[encoded_offsets[r] + done], std::min(encoded_sizes[r] - done, (unsigned long long)INT_MAX), MPI_BYTE, r, comm);
+        }
+
+        //The part of each selection within the slab, shifted to the slab's first row
+        std::vector<hid_t> parts(numprocs);
+        std::vector<unsigned long long> send_counts(numprocs), send_offsets(numprocs, 0);
+        std::vector<hssize_t> shift(nD, 0);
+        shift[0] = slab_start[0];
+
+        for (int r=0; r<numprocs; r++) {
+            parts[r] = H5Sdecode(&all_encoded[encoded_offsets[r]]);
+
+            if (slab_elements == 0)
+                H5Sselect_none(parts[r]);
+            else if (H5Sget_select_type(parts[r]) == H5S_SEL_ALL)
+                H5Sselect_hyperslab(parts[r], H5S_SELECT_SET, slab_start.data(), NULL, slab_count.data(), NULL);
+            else if (H5Sget_select_type(parts[r]) != H5S_SEL_NONE)
+                H5Sselect_hyperslab(parts[r], H5S_SELECT_AND, slab_start.data(), NULL, slab_count.data(), NULL);
+
+            send_counts[r] = H5Sget_select_npoints(parts[r]);
+
+            if (r > 0)
+                send_offsets[r] = send_offsets[r-1] + send_counts[r-1];
+        }
+
+        //Second phase, the slab's elements in the order each process reads them
+        std::vector<char> send(size_t(send_offsets[numprocs-1] + send_counts[numprocs-1])*size);
+
+        for (int r=0; r<numprocs; r++) {
+            if (send_counts[r] > 0) {
+#if H5_VERSION_GE(1,10,6)
+                H5Sselect_adjust(parts[r], shift.data());
+#else
+                //Older releases offset the selection instead, which H5Dgather honours too
+                std::vector<hssize_t> offset(nD);
+                for (int d=0; d<nD; d++)
+                    offset[d] = -shift[d];
+                H5Soffset_simple(parts[r], offset.data());
+#endif
+                H5Dgather(parts[r], slab.data(), dtype, size_t(send_counts[r])*size, &send[size_t(send_offsets[r])*size], NULL, NULL);
+            }
+
+            H5Sclose(parts[r]);
+        }
+
+        std::vector<char>().swap(slab);
+
+        std::vector<unsigned long long> receive_counts(numprocs), receive_offsets(numprocs, 0);
+        MPI_Alltoall(send_counts.data(), 1, MPI_UNSIGNED_LONG_LONG, receive_counts.data(), 1, MPI_UNSIGNED_LONG_LONG, comm);
+
+        for (int r=1; r<numprocs; r++)
+            receive_offsets[r] = receive_offsets[r-1] + receive_counts[r-1];
+
+        std::vector<char> receive(size_t(receive_offsets[numprocs-1] + receive_counts[numprocs-1])*size);
+
+        Alltoallv_large_(send.data(), send_counts, send_offsets, receive.data(), receive_counts, receive_offsets, size, comm);
+
+        if (!receive.empty()) {
+            Scatter_source_ source = {receive.data(), receive.size()};
+
+            if (H5Dscatter(Scatter_source_callback_, &source, dtype, memoryspace, data) < 0)
+                status = -1;
+        }
+
+        return status;
+#else
+        return this->transfer(false, dtype, memoryspace, filespace, data);
+#endif
+    }
+
+    //Append records to an extendable dataset
+    //'data' holds num_records records in the native format of the dataset's datatype.
+    //Records are copied to an in-memory buffer, the dataset is extended and written when
+    //the buffer is full, on flush() and on close(). Under mpio append() must be called by all
+    //processes with the same records, process 0 writes them.
+    //The default plan follows the dataset as it grows, a plan given with set_plan() is kept.
+    Dataset &Dataset::append(const void *data, hsize_t num_records) {
+        if (!this->isExtendable()) {
+            std::cerr << "Dataset::append: " << this->name_ << " is not an extendable dataset" << std::endl;
+            return *this;
+        }
+
+        std::string hooks = this->write_hooks();
+        if (!hooks.empty()) {
+            std::cerr << "Dataset::append: " << this->name_ << " has " << hooks << ", which append() does not update" << std::endl;
+            return *this;
+        }
+
+        const char *records = static_cast<const char*>(data);
+        size_t record_bytes = this->record_size();
+
+        //Nothing buffered and at least a full buffer given, skip the copy
+        if (this->num_buffered_records_ == 0 && num_records >= this->append_buffer_records_) {
+            this->write_records(records, num_records);
+            return *this;
+        }
+
+        if (this->append_buffer_.size() != this->append_buffer_records_*record_bytes)
+            this->append_buffer_.resize(this->append_buffer_records_*record_bytes);
+
+        while (num_records > 0) {
+            hsize_t n = std::min(num_records, this->append_buffer_records_ - this->num_buffered_records_);
+
+            std::memcpy(&this->append_buffer_[this->num_buffered_records_*record_bytes], records, n*record_bytes);
+
+            this->num_buffered_records_ += n;
+            records += n*record_bytes;
+            num_records -= n;
+
+            if (this->num_buffered_records_ == this->append_buffer_records_)
+                this->flush();
+        }
+
+        return *this;
+    }
+
+    //Write the records buffered by append()
+    void Dataset::flush() {
+        if (this->num_buffered_records_ == 0)
+            return;
+
+        hsize_t num_records = this->num_buffered_records_;
+        this->num_buffered_records_ = 0;
+
+        this->write_records(this->append_buffer_.data(), num_records);
+    }
+
+    //Extend the leading dimension by num_records and write them at the end
+    //The extent is read from the file first, as other handles of the dataset may have appended.
+    void Dataset::write_records(const void *data, hsize_t num_records) {
+        int nD = this->shape_.size();
+
+        hid_t space = H5Dget_space(this->id_);
+        H5Sget_simple_extent_dims(space, this->shape_.data(), NULL);
+        H5Sclose(space);
+
+        std::vector<hsize_t> start(nD, 0);
+        std::vector<hsize_t> count = this->shape_;
+
+        start[0] = this->shape_[0];
+        count[0] = num_records;
+
+        this->shape_[0] += num_records;
+        H5Dset_extent(this->id_, this->shape_.data());
+
+        hid_t filespace = H5Dget_space(this->id_);
+        hid_t memoryspace = H5Screate_simple(nD, count.data(), NULL);
+
+        H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start.data(), NULL, count.data(), NULL);
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            int my_id;
+            MPI_Comm_rank(this->MPI_COMMUNICATOR, &my_id);
+
+            if (my_id != 0) {
+                H5Sselect_none(filespace);
+                H5Sselect_none(memoryspace);
+            }
+        }
+#endif
+
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        H5Dwrite(this->id_, native_dtype, memoryspace, filespace, H5P_DEFAULT, data);
+
+        H5Tclose(native_dtype);
+        H5Sclose(memoryspace);
+        H5Sclose(filespace);
+
+        if (this->default_plan_)
+            this->set_default_plan();
+    }
+
+    //With a min/max index, a plan that is not a single box makes the blocks its writes touch unknown
+    Dataset &Dataset::set_plan(Plan plan) {
+        if (this->hasMinmaxIndex() && !this->isIndexable(plan))
+            std::cerr << "Dataset::set_plan: writes to " << this->name_ << " with this plan can not update its min/max index exactly, the blocks they touch become unknown" << std::endl;
+
+        this->plan = plan;
+        this->default_plan_ = false;
+        return *this;
+    }
+
+    //Dataset access property list with the chunk cache parameters, H5P_DEFAULT if none are set
+    hid_t Dataset::create_dapl() const {
+        if (this->chunk_cache_nbytes_ == 0)
+            return H5P_DEFAULT;
+
+        hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
+        H5Pset_chunk_cache(dapl, this->chunk_cache_nslots_, this->chunk_cache_nbytes_, this->chunk_cache_w0_);
+
+        return dapl;
+    }
+
+    /**
+     * \brief Sets the raw data chunk cache of this dataset, the dataset is reopened to apply it.
+     *
+     * \param nslots  [in] Number of hash table slots, preferably a prime about 100 times the
+     *                      number of chunks that fit in the cache.
+     * \param nbytes  [in] Size of the cache in bytes.
+     * \param w0      [in] Preemption policy in [0,1], 1 evicts fully read or written chunks first.
+     *
+     * Under mpio chunk caching is used only when the file is opened read-only.
+     */
+    Dataset &Dataset::set_chunk_cache(size_t nslots, size_t nbytes, double w0) {
+        this->chunk_cache_nslots_ = nslots;
+        this->chunk_cache_nbytes_ = nbytes;
+        this->chunk_cache_w0_ = w0;
+
+        if (this->id_ > 0) {
+            this->flush();
+            H5Dclose(this->id_);
+
+            hid_t dapl = this->create_dapl();
+            this->id_ = H5Dopen2(this->parent_->id(), this->name_.c_str(), dapl);
+            if (dapl != H5P_DEFAULT)
+                H5Pclose(dapl);
+        }
+
+        return *this;
+    }
+
+    static size_t Next_prime(size_t n) {
+        for (;; n++) {
+            bool is_prime = (n >= 2);
+            for (size_t i=2; i*i<=n && is_prime; i++)
+                if (n % i == 0)
+                    is_prime = false;
+
+            if (is_prime)
+                return n;
+        }
+    }
+
+    /**
+     * \brief Sizes the chunk cache so that all chunks touched by the plan's file space selection
+     * fit, at most max_nbytes.
+     *
+     * Repeated reads of neighbouring pencils or slices through the same chunks then find them
+     * in the cache instead of reading and decompressing them again. Has no effect on datasets
+     * that are not chunked.
+     */
+    Dataset &Dataset::auto_chunk_cache(size_t max_nbytes) {
+        hid_t dcpl = H5Dget_create_plist(this->id_);
+
+        if (H5Pget_layout(dcpl) != H5D_CHUNKED) {
+            H5Pclose(dcpl);
+            return *this;
+        }
+
+        int nD = this->shape_.size();
+        std::vector<hsize_t> chunk(nD), start(nD), end(nD);
+
+        H5Pget_chunk(dcpl, nD, chunk.data());
+        H5Pclose(dcpl);
+
+        if (H5Sget_select_npoints(this->plan.filespace()) <= 0)
+            return *this;
+
+        H5Sget_select_bounds(this->plan.filespace(), start.data(), end.data());
+
+        size_t chunk_nbytes = H5Tget_size(this->filespace_dtype_);
+        size_t num_chunks = 1;
+
+        for (int d=0; d<nD; d++) {
+            chunk_nbytes *= chunk[d];
+            num_chunks *= end[d]/chunk[d] - start[d]/chunk[d] + 1;
+        }
+
+        size_t nbytes = std::min(num_chunks*chunk_nbytes, std::max(max_nbytes, chunk_nbytes));
+
+        num_chunks = nbytes/chunk_nbytes;
+
+        return this->set_chunk_cache(Next_prime(100*num_chunks), nbytes, 0.75);
+    }
+
+    //Reduce the whole dataset with one of the operators of Moments, e.g. ds.reduce("max")
+    double Dataset::reduce(std::string op, size_t memory_budget) const {
+        return this->reduce(op, Select::all(this->shape_.size()), memory_budget);
+    }
+
+    double Dataset::reduce(std::string op, Select select, size_t memory_budget) const {
+        if (!Moments::isOperator(op)) {
+            std::cerr << "Unknown reduction '" << op << "', expected one of count, min, max, sum, mean, l2, rms, energy" << std::endl;
+            exit(1);
+        }
+
+        Moments moments;
+        this->reduce(moments, select, memory_budget);
+
+        return moments.value(op);
+    }
+
+    /**
+     * Streams the box select of the dataset through reduction, slab by slab, with at most about
+     * memory_budget bytes of the dataset in memory. Values are converted to double in blocks
+     * small enough to stay in cache. Under mpio the slabs are shared round robin among the
+     * processes and the partial results combined, so every process gets the full result.
+     */
+    void Dataset::reduce(Reduction &reduction, Select select, size_t memory_budget) const {
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        Convert::Kind kind = Convert::kind(native_dtype);
+        size_t dtype_size = H5Tget_size(native_dtype);
+        H5Tclose(native_dtype);
+
+        if (kind == Convert::NONE) {
+            std::cerr << "Dataset " << this->name_ << ": reduce() supports only integer and floating point datasets" << std::endl;
+            exit(1);
+        }
+
+        SlabIterator slab(*this, select, memory_budget);
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            int my_id, numprocs;
+            MPI_Comm_rank(this->MPI_COMMUNICATOR, &my_id);
+            MPI_Comm_size(this->MPI_COMMUNICATOR, &numprocs);
+            slab.partition(my_id, numprocs);
+        }
+#endif
+
+        const size_t block = 4096;
+        std::vector<double> values(block);
+
+        while (slab.next()) {
+            const char *data = slab.data<char>();
+            size_t n = slab.size();
+
+            for (size_t i=0; i<n; i+=block) {
+                size_t m = std::min(block, n-i);
+                const double *block_values = reinterpret_cast<const double*>(data + i*dtype_size);
+
+                if (kind != Convert::DOUBLE) {
+                    Convert::run(kind, Convert::DOUBLE, data + i*dtype_size, values.data(), m);
+                    block_values = values.data();
+                }
+
+                reduction.accumulate(block_values, m);
+            }
+        }
+
+        if (slab.status() < 0)
+            std::cerr << "Dataset::reduce: " << this->name_ << " was not fully read, the result is incomplete" << std::endl;
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio")
+            reduction.combine(this->MPI_COMMUNICATOR);
+#endif
+    }
+
+    //Feed the values of the memory selection of data to reduction, converted to double in
+    //cache sized blocks. Only 'all' and hyperslab selections are supported.
+    static void Reduce_selection(hid_t memoryspace, hid_t dtype, const void *data, Reduction &reduction) {
+        Convert::Kind kind = Convert::kind(dtype);
+        size_t dtype_size = H5Tget_size(dtype);
+        int nD = H5Sget_simple_extent_ndims(memoryspace);
+
+        if (kind == Convert::NONE || nD < 1)
+            return;
+
+        std::vector<hsize_t> extent(nD);
+        H5Sget_simple_extent_dims(memoryspace, extent.data(), NULL);
+
+        //Corners of the blocks, start and end of block 0 followed by those of block 1 and so on
+        std::vector<hsize_t> blocks;
+        hssize_t num_blocks;
+
+        switch (H5Sget_select_type(memoryspace)) {
+            case H5S_SEL_ALL:
+                num_blocks = 1;
+                blocks.assign(2*nD, 0);
+                for (int d=0; d<nD; d++)
+                    blocks[nD+d] = extent[d] - 1;
+                break;
+
+            case H5S_SEL_HYPERSLABS:
+                num_blocks = H5Sget_select_hyper_nblocks(memoryspace);
+                blocks.resize(2*nD*num_blocks);
+                H5Sget_select_hyper_blocklist(memoryspace, 0, num_blocks, blocks.data());
+                break;
+
+            default:
+                return;
+        }
+
+        const size_t block_size = 4096;
+        std::vector<double> values(block_size);
+        const char *bytes = static_cast<const char*>(data);
+
+        for (hssize_t b=0; b<num_blocks; b++) {
+            const hsize_t *start = &blocks[2*nD*b];
+            const hsize_t *end = start + nD;
+            std::vector<hsize_t> index(start, start + nD);
+
+            hsize_t run = end[nD-1] - start[nD-1] + 1;
+
+            //Runs along the last dimension, odometer over the others
+            while (true) {
+                hsize_t offset = 0;
+                for (int d=0; d<nD; d++)
+                    offset = offset*extent[d] + index[d];
+
+                for (hsize_t i=0; i<run; i+=block_size) {
+                    size_t m = std::min(hsize_t(block_size), run-i);
+                    Convert::run(kind, Convert::DOUBLE, bytes + (offset+i)*dtype_size, values.data(), m);
+                    reduction.accumulate(values.data(), m);
+                }
+
+                int d = nD-2;
+                while (d >= 0 && index[d] == end[d]) {
+                    index[d] = start[d];
+                    d--;
+                }
+
+                if (d < 0)
+                    break;
+
+                index[d]++;
+            }
+        }
+    }
+
+    /**
+     * Compute statistics of the data on every write through this Dataset and store them as
+     * attributes of the dataset: "stat_count", "stat_min", "stat_max", "stat_mean" and "stat_rms"
+     * and, when histogram_bins > 0, "stat_histogram" with the counts in histogram_bins equal bins
+     * of [histogram_min, histogram_max], stored as "stat_histogram_range". The range is fixed so
+     * that the histogram is filled in the same pass as the moments, values outside it go to the
+     * first or last bin and non-finite values to none.
+     * The values are those written, after conversion and rounding. Only values in the memory
+     * selection of the plan are counted, so ghost cells are left out, and under mpio the
+     * statistics are of the whole write of all processes. The attributes are not changed when
+     * the write fails. Complex and other non-numeric datatypes are skipped.
+     */
+    Dataset &Dataset::set_statistics(int histogram_bins, double histogram_min, double histogram_max) {
+        this->statistics_bins_ = std::max(histogram_bins, 0);
+        this->statistics_range_.clear();
+
+        if (this->statistics_bins_ > 0) {
+            if (!(histogram_min < histogram_max)) {
+                std::cerr << "Dataset::set_statistics: " << this->name_ << ": the histogram needs a range histogram_min < histogram_max, it is left out" << std::endl;
+                this->statistics_bins_ = 0;
+            }
+            else {
+                this->statistics_range_.push_back(histogram_min);
+                this->statistics_range_.push_back(histogram_max);
+            }
+        }
+
+        return *this;
+    }
+
+    //Statistics of a write of data described by dtype and memoryspace, which returned status
+    void Dataset::update_statistics(hid_t dtype, hid_t memoryspace, const void *data, herr_t status) const {
+        if (this->statistics_bins_ < 0 || Convert::kind(dtype) == Convert::NONE)
+            return;
+
+        Moments moments;
+        Histogram histogram(this->statistics_range_.empty() ? 0 : this->statistics_range_[0], this->statistics_range_.empty() ? 0 : this->statistics_range_[1], this->statistics_bins_);
+        Statistics_ statistics(moments, this->statistics_bins_ > 0 ? &histogram : NULL);
+
+        Reduce_selection(memoryspace, dtype, data, statistics);
+
+        this->store_statistics(moments, histogram, status);
+    }
+
+    //Combine the statistics of the processes and store them, unless the write failed on any of them
+    void Dataset::store_statistics(Moments &moments, Histogram &histogram, herr_t status) const {
+        bool failed = (status < 0);
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            Statistics_ statistics(moments, this->statistics_bins_ > 0 ? &histogram : NULL);
+            statistics.combine(this->MPI_COMMUNICATOR);
+
+            int local_failed = failed, any_failed;
+            MPI_Allreduce(&local_failed, &any_failed, 1, MPI_INT, MPI_MAX, this->MPI_COMMUNICATOR);
+            failed = (any_failed != 0);
+        }
+#endif
+
+        if (failed)
+            return;
+
+        write_attribute(this->id_, "stat_count", moments.count());
+        write_attribute(this->id_, "stat_min", moments.min());
+        write_attribute(this->id_, "stat_max", moments.max());
+        write_attribute(this->id_, "stat_mean", moments.mean());
+        write_attribute(this->id_, "stat_rms", moments.rms());
+
+        if (this->statistics_bins_ > 0) {
+            write_attribute(this->id_, "stat_histogram", histogram.counts());
+            write_attribute(this->id_, "stat_histogram_range", this->statistics_range_);
+        }
+    }
+
+    //Start and count of the selection of space if it is a single box, a count of zeros if nothing is selected
+    static bool Get_box(hid_t space, std::vector<hsize_t> &start, std::vector<hsize_t> &count) {
+        int nD = H5Sget_simple_extent_ndims(space);
+
+        start.assign(nD, 0);
+        count.assign(nD, 0);
+
+        switch (H5Sget_select_type(space)) {
+            case H5S_SEL_NONE:
+                return true;
+
+            case H5S_SEL_ALL:
+                H5Sget_simple_extent_dims(space, count.data(), NULL);
+                return true;
+
+            case H5S_SEL_HYPERSLABS: {
+                if (H5Sget_select_hyper_nblocks(space) != 1)
+                    return false;
+
+                std::vector<hsize_t> end(nD);
+                H5Sget_select_bounds(space, start.data(), end.data());
+
+                for (int d=0; d<nD; d++)
+                    count[d] = end[d] - start[d] + 1;
+
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    //Whether a block with values in [min, max] may hold values satisfying 'op value'
+    static bool Block_matches(std::string op, double min, double max, double value) {
+        if (op == ">")  return max > value;
+        if (op == ">=") return max >= value;
+        if (op == "<")  return min < value;
+        if (op == "<=") return min <= value;
+        if (op == "==") return min <= value && value <= max;
+        if (op == "!=") return !(min == value && max == value);
+
+        std::cerr << "Unknown comparison '" << op << "', expected one of >, >=, <, <=, ==, !=" << std::endl;
+        exit(1);
+    }
+
+    std::string Dataset::index_name() const {
+        return this->name_ + ".minmax";
+    }
+
+    /**
+     * Min, max and number of points of the blocks covered by a box of data. The box of shape
+     * count lies at memory_start in a memory of the given extent and at file_start in the dataset.
+     * Block indices are taken relative to first_block, in a box of num_blocks blocks.
+     * Rows along the last dimension are split where they cross block boundaries.
+     */
+    static void Block_minmax_(Convert::Kind kind, size_t dtype_size, const void *data, const std::vector<hsize_t> &extent,
+                              const std::vector<hsize_t> &memory_start, const std::vector<hsize_t> &file_start, const std::vector<hsize_t> &count,
+                              const std::vector<hsize_t> &block, const std::vector<hsize_t> &first_block, const std::vector<hsize_t> &num_blocks,
+                              std::vector<double> &min, std::vector<double> &max, std::vector<double> &covered) {
+        int nD = count.size();
+        int last = nD-1;
+
+        hsize_t num_points = 1;
+        for (int d=0; d<nD; d++)
+            num_points *= count[d];
+
+        if (num_points == 0)
+            return;
+
+        std::vector<hsize_t> index(nD, 0);
+        std::vector<double> row(count[last]);
+        const char *bytes = static_cast<const char*>(data);
+
+        while (true) {
+            hsize_t offset = 0, block_offset = 0;
+
+            for (int d=0; d<last; d++) {
+                offset = offset*extent[d] + memory_start[d] + index[d];
+                block_offset = block_offset*num_blocks[d] + (file_start[d] + index[d])/block[d] - first_block[d];
+            }
+            offset = offset*extent[last] + memory_start[last];
+
+            Convert::run(kind, Convert::DOUBLE, bytes + offset*dtype_size, row.data(), count[last]);
+
+            for (hsize_t j=0; j<count[last]; ) {
+                hsize_t b = (file_start[last] + j)/block[last];
+                hsize_t end = std::min(count[last], (b+1)*block[last] - file_start[last]);
+                hsize_t i = block_offset*num_blocks[last] + b - first_block[last];
+
+                for (hsize_t k=j; k<end; k++) {
+                    min[i] = (row[k] < min[i] ? row[k] : min[i]);
+                    max[i] = (row[k] > max[i] ? row[k] : max[i]);
+                }
+
+                covered[i] += end - j;
+                j = end;
+            }
+
+            int d = last-1;
+            while (d >= 0 && index[d] == count[d]-1) {
+                index[d] = 0;
+                d--;
+            }
+
+            if (d < 0)
+                break;
+
+            index[d]++;
+        }
+    }
+
+    //Whether writes with the plan can update the min/max index exactly, else the blocks they touch become unknown
+    bool Dataset::isIndexable(const Plan &plan) const {
+        std::vector<hsize_t> memoryspace_start, filespace_start, count, filespace_count;
+
+        return Get_box(plan.memoryspace(), memoryspace_start, count) && Get_box(plan.filespace(), filespace_start, filespace_count) && count == filespace_count;
+    }
+
+    /**
+     * Maintain an index of the minimum and maximum value of every block of the dataset, updated
+     * on each write through this Dataset. Blocks default to the chunks of a chunked dataset.
+     * The index is the dataset "<name>.minmax" next to this one, of shape [number of blocks along
+     * each dimension..., 2], with the block shape in its attribute "block".
+     *
+     * A new index is built from the current contents of the dataset, whatever was written before
+     * or the fill value, so it is exact from the start. Blocks wholly covered by a write then get
+     * exact values, blocks partially covered keep the union of their old and new ranges, so the
+     * index may grow loose but never misses a value. Writes must use plans whose memory and
+     * file selections are single boxes, the blocks touched by other writes become unknown,
+     * [-inf, inf]. Errors leave the dataset without an index. Collective under mpio.
+     */
+    Dataset &Dataset::set_minmax_index(std::vector<hsize_t> block) {
+        int nD = this->shape_.size();
+
+        if (block.empty()) {
+            hid_t dcpl = H5Dget_create_plist(this->id_);
+
+            if (H5Pget_layout(dcpl) == H5D_CHUNKED) {
+                block.resize(nD);
+                H5Pget_chunk(dcpl, nD, block.data());
+            }
+
+            H5Pclose(dcpl);
+        }
+
+        if (int(block.size()) != nD || this->isExtendable() || std::count(block.begin(), block.end(), hsize_t(0)) > 0) {
+            std::cerr << "Dataset::set_minmax_index: " << this->name_ << " needs a block of " << nD << " dimensions and a fixed shape" << std::endl;
+            return *this;
+        }
+
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        Convert::Kind kind = Convert::kind(native_dtype);
+        H5Tclose(native_dtype);
+
+        if (kind == Convert::NONE) {
+            std::cerr << "Dataset::set_minmax_index: " << this->name_ << " is not of an integer or floating point datatype" << std::endl;
+            return *this;
+        }
+
+        if (!this->isIndexable(this->plan)) {
+            std::cerr << "Dataset::set_minmax_index: " << this->name_ << " needs a plan with a single box in memory and in file" << std::endl;
+            return *this;
+        }
+
+        std::vector<hsize_t> dimension(nD+1, 2);
+        for (int d=0; d<nD; d++)
+            dimension[d] = (this->shape_[d] + block[d] - 1)/block[d];
+
+        hid_t index;
+        bool is_new = false;
+
+        if (H5Lexists(this->parent_->id(), this->index_name().c_str(), H5P_DEFAULT) > 0) {
+            index = H5Dopen2(this->parent_->id(), this->index_name().c_str(), H5P_DEFAULT);
+
+            std::vector<hsize_t> stored_block;
+            read_attribute(index, "block", stored_block);
+
+            if (stored_block != block) {
+                std::cerr << "Dataset::set_minmax_index: " << this->index_name() << " exists with a different block shape" << std::endl;
+                H5Dclose(index);
+                return *this;
+            }
+        }
+        else {
+            hid_t space = H5Screate_simple(nD+1, dimension.data(), NULL);
+            index = H5Dcreate2(this->parent_->id(), this->index_name().c_str(), H5T_IEEE_F64LE, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+            H5Sclose(space);
+
+            write_attribute(index, "block", block);
+            is_new = true;
+        }
+
+        H5Dclose(index);
+
+        this->index_block_ = block;
+
+        if (is_new)
+            this->build_minmax_index();
+
+        return *this;
+    }
+
+    bool Dataset::hasMinmaxIndex() const {
+        return !this->index_block_.empty();
+    }
+
+    //Fill a new index from the contents of the dataset, read in slabs shared among the processes
+    void Dataset::build_minmax_index() const {
+        int nD = this->shape_.size();
+        const std::vector<hsize_t> &block = this->index_block_;
+
+        std::vector<hsize_t> first_block(nD, 0), num_blocks(nD);
+        hsize_t total_blocks = 1;
+
+        for (int d=0; d<nD; d++) {
+            num_blocks[d] = (this->shape_[d] + block[d] - 1)/block[d];
+            total_blocks *= num_blocks[d];
+        }
+
+        std::vector<double> min(total_blocks, std::numeric_limits<double>::infinity());
+        std::vector<double> max(total_blocks, -std::numeric_limits<double>::infinity());
+        std::vector<double> covered(total_blocks, 0);
+
+        hid_t native_dtype = Convert::native_dtype(this->filespace_dtype_);
+        Convert::Kind kind = Convert::kind(native_dtype);
+        size_t dtype_size = H5Tget_size(native_dtype);
+        H5Tclose(native_dtype);
+
+        SlabIterator slab(*this, 67108864, false);
+        int my_id = 0;
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            int numprocs;
+            MPI_Comm_rank(this->MPI_COMMUNICATOR, &my_id);
+            MPI_Comm_size(this->MPI_COMMUNICATOR, &numprocs);
+            slab.partition(my_id, numprocs);
+        }
+#endif
+
+        while (slab.next()) {
+            std::vector<hsize_t> shape = slab.shape();
+            std::vector<hsize_t> memory_start(nD, 0);
+
+            Block_minmax_(kind, dtype_size, slab.data(), shape, memory_start, slab.start(), shape, block, first_block, num_blocks, min, max, covered);
+        }
+
+        //Blocks of a slab that could not be read are unknown
+        if (slab.status() < 0) {
+            std::fill(min.begin(), min.end(), -std::numeric_limits<double>::infinity());
+            std::fill(max.begin(), max.end(), std::numeric_limits<double>::infinity());
+        }
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            MPI_Allreduce(MPI_IN_PLACE, min.data(), total_blocks, MPI_DOUBLE, MPI_MIN, this->MPI_COMMUNICATOR);
+            MPI_Allreduce(MPI_IN_PLACE, max.data(), total_blocks, MPI_DOUBLE, MPI_MAX, this->MPI_COMMUNICATOR);
+        }
+#endif
+
+        std::vector<double> stored(2*total_blocks);
+        for (hsize_t i=0; i<total_blocks; i++) {
+            stored[2*i] = min[i];
+            stored[2*i+1] = max[i];
+        }
+
+        //Every process holds the same index, process 0 writes it
+        hid_t index_id = H5Dopen2(this->parent_->id(), this->index_name().c_str(), H5P_DEFAULT);
+
+        if (my_id == 0)
+            H5Dwrite(index_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, stored.data());
+
+        H5Dclose(index_id);
+    }
+
+    /**
+     * Called after a write of data described by dtype and memoryspace to the plan's file selection.
+     * Only the box of blocks touched by the write of any process is reduced, read and rewritten.
+     * A write that can not be indexed exactly, for its plan or datatype, makes the blocks it
+     * touches unknown.
+     */
+    void Dataset::update_minmax_index(hid_t dtype, hid_t memoryspace, const void *data) const {
+        if (this->index_block_.empty())
+            return;
+
+        int nD = this->shape_.size();
+        const std::vector<hsize_t> &block = this->index_block_;
+        hid_t filespace = this->plan.filespace();
+
+        std::vector<hsize_t> memoryspace_start, filespace_start, count, filespace_count;
+        bool is_box = Get_box(memoryspace, memoryspace_start, count) && Get_box(filespace, filespace_start, filespace_count) && count == filespace_count;
+
+        Convert::Kind kind = Convert::kind(dtype);
+        size_t dtype_size = H5Tget_size(dtype);
+
+        //Blocks touched by this process, [first_block, end_block) along each dimension
+        std::vector<unsigned long long> first_block(nD, ULLONG_MAX), end_block(nD, 0);
+
+        if (H5Sget_select_npoints(filespace) > 0) {
+            std::vector<hsize_t> low(nD), high(nD);
+            H5Sget_select_bounds(filespace, low.data(), high.data());
+
+            for (int d=0; d<nD; d++) {
+                first_block[d] = low[d]/block[d];
+                end_block[d] = high[d]/block[d] + 1;
+            }
+        }
+
+        //Blocks touched by any process
+        std::vector<unsigned long long> box_first = first_block, box_end = end_block;
+        int my_id = 0;
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            MPI_Comm_rank(this->MPI_COMMUNICATOR, &my_id);
+            MPI_Allreduce(MPI_IN_PLACE, box_first.data(), nD, MPI_UNSIGNED_LONG_LONG, MPI_MIN, this->MPI_COMMUNICATOR);
+            MPI_Allreduce(MPI_IN_PLACE, box_end.data(), nD, MPI_UNSIGNED_LONG_LONG, MPI_MAX, this->MPI_COMMUNICATOR);
+        }
+#endif
+
+        for (int d=0; d<nD; d++)
+            if (box_end[d] <= box_first[d])
+                return;
+
+        std::vector<hsize_t> index_first(box_first.begin(), box_first.end()), num_blocks(nD);
+        hsize_t total_blocks = 1;
+
+        for (int d=0; d<nD; d++) {
+            num_blocks[d] = box_end[d] - box_first[d];
+            total_blocks *= num_blocks[d];
+        }
+
+        //Min, max and number of written points of every block of the box, gathered over all processes
+        std::vector<double> min(total_blocks, std::numeric_limits<double>::infinity());
+        std::vector<double> max(total_blocks, -std::numeric_limits<double>::infinity());
+        std::vector<double> covered(total_blocks, 0);
+
+        if (is_box && kind != Convert::NONE) {
+            std::vector<hsize_t> extent(nD);
+            H5Sget_simple_extent_dims(memoryspace, extent.data(), NULL);
+
+            Block_minmax_(kind, dtype_size, data, extent, memoryspace_start, filespace_start, count, block, index_first, num_blocks, min, max, covered);
+        }
+        else if (first_block[0] < end_block[0]) {
+            std::cerr << "Dataset " << this->name_ << ": the write can not be indexed, it needs a plan with a single box in memory and in file and numeric data, the blocks it touches become unknown" << std::endl;
+
+            //Unknown and partially covered, so the union with the stored range is [-inf, inf] too
+            std::vector<hsize_t> b(first_block.begin(), first_block.end());
+
+            while (true) {
+                hsize_t i = 0;
+                for (int d=0; d<nD; d++)
+                    i = i*num_blocks[d] + b[d] - index_first[d];
+
+                min[i] = -std::numeric_limits<double>::infinity();
+                max[i] = std::numeric_limits<double>::infinity();
+                covered[i] = std::max(covered[i], 0.5);
+
+                int d = nD-1;
+                while (d >= 0 && b[d] == end_block[d]-1) {
+                    b[d] = first_block[d];
+                    d--;
+                }
+
+                if (d < 0)
+                    break;
+
+                b[d]++;
+            }
+        }
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            MPI_Allreduce(MPI_IN_PLACE, min.data(), total_blocks, MPI_DOUBLE, MPI_MIN, this->MPI_COMMUNICATOR);
+            MPI_Allreduce(MPI_IN_PLACE, max.data(), total_blocks, MPI_DOUBLE, MPI_MAX, this->MPI_COMMUNICATOR);
+            MPI_Allreduce(MPI_IN_PLACE, covered.data(), total_blocks, MPI_DOUBLE, MPI_SUM, this->MPI_COMMUNICATOR);
+        }
+#endif
+
+        //Every process holds the same box of the index, process 0 reads and writes it
+        hid_t index_id = H5Dopen2(this->parent_->id(), this->index_name().c_str(), H5P_DEFAULT);
+
+        if (my_id == 0) {
+            std::vector<hsize_t> start(nD+1, 0), index_count(nD+1, 2);
+            for (int d=0; d<nD; d++) {
+                start[d] = index_first[d];
+                index_count[d] = num_blocks[d];
+            }
+
+            hid_t index_filespace = H5Dget_space(index_id);
+            H5Sselect_hyperslab(index_filespace, H5S_SELECT_SET, start.data(), NULL, index_count.data(), NULL);
+            hid_t index_memoryspace = H5Screate_simple(nD+1, index_count.data(), NULL);
+
+            std::vector<double> stored(2*total_blocks);
+            H5Dread(index_id, H5T_NATIVE_DOUBLE, index_memoryspace, index_filespace, H5P_DEFAULT, stored.data());
+
+            for (hsize_t i=0; i<total_blocks; i++) {
+                if (covered[i] == 0)
+                    continue;
+
+                //Points of block i inside the dataset
+                double volume = 1;
+                hsize_t r = i;
+                for (int d=nD-1; d>=0; d--) {
+                    hsize_t b = index_first[d] + r % num_blocks[d];
+                    volume *= std::min(block[d], this->shape_[d] - b*block[d]);
+                    r /= num_blocks[d];
+                }
+
+                if (covered[i] < volume) {
+                    min[i] = std::min(min[i], stored[2*i]);
+                    max[i] = std::max(max[i], stored[2*i+1]);
+                }
+
+                stored[2*i] = min[i];
+                stored[2*i+1] = max[i];
+            }
+
+            H5Dwrite(index_id, H5T_NATIVE_DOUBLE, index_memoryspace, index_filespace, H5P_DEFAULT, stored.data());
+
+            H5Sclose(index_memoryspace);
+            H5Sclose(index_filespace);
+        }
+
+        H5Dclose(index_id);
+    }
+
+    /**
+     * Blocks of the dataset that may hold values satisfying 'op value', op being one of
+     * >, >=, <, <=, == and !=, from the min/max index. Every process gets all candidate blocks.
+     */
+    Expression Dataset::candidates(std::string op, double value) const {
+        Expression blocks;
+
+        if (this->index_block_.empty()) {
+            std::cerr << "Dataset::candidates: " << this->name_ << " has no min/max index, see set_minmax_index()" << std::endl;
+            return blocks;
+        }
+
+        int nD = this->shape_.size();
+        const std::vector<hsize_t> &block = this->index_block_;
+
+        hid_t index_id = H5Dopen2(this->parent_->id(), this->index_name().c_str(), H5P_DEFAULT);
+        hid_t space = H5Dget_space(index_id);
+
+        std::vector<hsize_t> num_blocks(nD+1);
+        H5Sget_simple_extent_dims(space, num_blocks.data(), NULL);
+
+        std::vector<double> stored(H5Sget_simple_extent_npoints(space));
+        H5Dread(index_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, stored.data());
+
+        H5Sclose(space);
+        H5Dclose(index_id);
+
+        for (hsize_t i=0; i<stored.size()/2; i++) {
+            if (!Block_matches(op, stored[2*i], stored[2*i+1], value))
+                continue;
+
+            Select select = Select::all(nD);
+
+            hsize_t r = i;
+            for (int d=nD-1; d>=0; d--) {
+                hsize_t b = r % num_blocks[d];
+                select[d] = Range(b*block[d], std::min((b+1)*block[d], this->shape_[d]) - 1);
+                r /= num_blocks[d];
+            }
+
+            blocks.Add_select(select);
+        }
+
+        return blocks;
+    }
+
+    //Read the candidate blocks for 'op value', one after the other, each in row major order and
+    //converted to double. The blocks are returned in 'blocks'.
+    std::vector<double> Dataset::query(std::string op, double value, Expression &blocks) const {
+        blocks = this->candidates(op, value);
+
+        int nD = this->shape_.size();
+        std::vector<double> values;
+        std::vector<hsize_t> start(nD), count(nD);
+
+        hid_t filespace = H5Dget_space(this->id_);
+
+        for (size_t s=0; s<blocks.size(); s++) {
+            hsize_t num_points = 1;
+
+            for (int d=0; d<nD; d++) {
+                start[d] = blocks[s][d].first(0);
+                count[d] = blocks[s][d].last(0) - start[d] + 1;
+                num_points *= count[d];
+            }
+
+            H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start.data(), NULL, count.data(), NULL);
+            hid_t memoryspace = H5Screate_simple(nD, count.data(), NULL);
+
+            values.resize(values.size() + num_points);
+            H5Dread(this->id_, H5T_NATIVE_DOUBLE, memoryspace, filespace, H5P_DEFAULT, &values[values.size() - num_points]);
+
+            H5Sclose(memoryspace);
+        }
+
+        H5Sclose(filespace);
+        return values;
+    }
+
+    /**
+     * Halve a local box of a pyramid level along every dimension. The box holds the sums and
+     * counts of the points of the full resolution dataset falling in each of its cells, or with
+     * stride the point at the first corner of each cell (counts are then all 1).
+     * origin and extent give the position of the box in the level, they are updated to the
+     * position of the halved box in the next level.
+     */
+    static void Halve_box(bool stride, std::vector<hsize_t> &origin, std::vector<hsize_t> &extent, std::vector<double> &sum, std::vector<double> &count) {
+        int nD = origin.size();
+
+        std::vector<hsize_t> next_origin(nD), next_extent(nD);
+        hsize_t num_points = 1;
+
+        for (int d=0; d<nD; d++) {
+            next_origin[d] = (origin[d] + 1)/2;
+            next_extent[d] = (origin[d] + extent[d] + 1)/2 - next_origin[d];
+            num_points *= next_extent[d];
+        }
+
+        std::vector<double> next_sum(num_points, 0), next_count(num_points, 0);
+        std::vector<hsize_t> index(nD, 0);
+
+        for (hsize_t p=0; p<num_points; p++) {
+            //Children 2*(next_origin + index) + corner that lie in the box
+            for (int corner=0; corner < (stride ? 1 : 1<<nD); corner++) {
+                hsize_t q = 0;
+                bool inside = true;
+
+                for (int d=0; d<nD; d++) {
+                    hsize_t i = 2*(next_origin[d] + index[d]) + ((corner>>(nD-1-d)) & 1);
+
+                    if (i >= origin[d] + extent[d]) {
+                        inside = false;
+                        break;
+                    }
+
+                    q = q*extent[d] + (i - origin[d]);
+                }
+
+                if (inside) {
+                    next_sum[p] += sum[q];
+                    next_count[p] += count[q];
+                }
+            }
+
+            for (int d=nD-1; d>=0; d--) {
+                if (++index[d] < next_extent[d])
+                    break;
+                index[d] = 0;
+            }
+        }
+
+        origin = next_origin;
+        extent = next_extent;
+        sum.swap(next_sum);
+        count.swap(next_count);
+    }
+
+    std::string Dataset::level_name(int level) const {
+        std::ostringstream name;
+        name << this->name_ << ".level" << level;
+        return name.str();
+    }
+
+    /**
+     * Write levels 1 to 'levels' of downsampled copies of the dataset on every write through this
+     * Dataset, as the datasets "<name>.level1", "<name>.level2" and so on next to this one. Level l
+     * has ceil(N/2^l) points along a dimension of N points, and holds with method "stride" every
+     * 2^l-th point and with method "mean" the mean of cells of 2^l points along each dimension.
+     * Levels are computed by each process from its own box and written with the file datatype of
+     * this dataset. Means of cells cut by the boundaries between the boxes of processes are over
+     * the part of the cell in the box holding its first corner, so they are exact when boxes
+     * start at multiples of 2^levels. Writes must use plans with single box selections.
+     * Collective under mpio.
+     */
+    Dataset &Dataset::set_pyramid(int levels, std::string method) {
+        if (method != "stride" && method != "mean") {
+            std::cerr << "Dataset::set_pyramid: Unknown method '" << method << "', expected stride or mean" << std::endl;
+            exit(1);
+        }
+
+        int nD = this->shape_.size();
+        hid_t file_dtype = H5Dget_type(this->id_);
+
+        for (int l=1; l<=levels; l++) {
+            if (H5Lexists(this->parent_->id(), this->level_name(l).c_str(), H5P_DEFAULT) > 0)
+                continue;
+
+            std::vector<hsize_t> dimension(nD);
+            for (int d=0; d<nD; d++)
+                dimension[d] = (this->shape_[d] + (hsize_t(1)<<l) - 1) >> l;
+
+            hid_t space = H5Screate_simple(nD, dimension.data(), NULL);
+            hid_t level = H5Dcreate2(this->parent_->id(), this->level_name(l).c_str(), file_dtype, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+            write_attribute(level, "level", l);
+            write_attribute(level, "method", method);
+
+            H5Dclose(level);
+            H5Sclose(space);
+        }
+
+        H5Tclose(file_dtype);
+
+        this->pyramid_levels_ = levels;
+        this->pyramid_method_ = method;
+        return *this;
+    }
+
+    bool Dataset::hasPyramid() const {
+        return this->pyramid_levels_ > 0;
+    }
+
+    //Called after a write of data described by dtype and memoryspace
+    void Dataset::update_pyramid(hid_t dtype, hid_t memoryspace, const void *data) const {
+        if (this->pyramid_levels_ <= 0)
+            return;
+
+        int nD = this->shape_.size();
+        int last = nD-1;
+
+        std::vector<hsize_t> memoryspace_start, origin, extent, filespace_count;
+
+        if (!Get_box(memoryspace, memoryspace_start, extent) || !Get_box(this->plan.filespace(), origin, filespace_count) || extent != filespace_count) {
+            std::cerr << "Dataset " << this->name_ << ": pyramid levels need plans with a single box in memory and in file" << std::endl;
+            exit(1);
+        }
+
+        Convert::Kind kind = Convert::kind(dtype);
+        size_t dtype_size = H5Tget_size(dtype);
+
+        if (kind == Convert::NONE) {
+            std::cerr << "Dataset " << this->name_ << ": pyramid levels support only integer and floating point data" << std::endl;
+            exit(1);
+        }
+
+        //Level 0, the box of this process converted to double
+        std::vector<hsize_t> memoryspace_extent(nD);
+        H5Sget_simple_extent_dims(memoryspace, memoryspace_extent.data(), NULL);
+
+        hsize_t num_points = 1;
+        for (int d=0; d<nD; d++)
+            num_points *= extent[d];
+
+        std::vector<double> sum(num_points), count(num_points, 1);
+        std::vector<hsize_t> index(nD, 0);
+        const char *bytes = static_cast<const char*>(data);
+
+        for (hsize_t row=0; row<num_points; row+=extent[last]) {
+            hsize_t offset = 0;
+            for (int d=0; d<last; d++)
+                offset = offset*memoryspace_extent[d] + memoryspace_start[d] + index[d];
+            offset = offset*memoryspace_extent[last] + memoryspace_start[last];
+
+            Convert::run(kind, Convert::DOUBLE, bytes + offset*dtype_size, &sum[row], extent[last]);
+
+            for (int d=last-1; d>=0; d--) {
+                if (++index[d] < extent[d])
+                    break;
+                index[d] = 0;
+            }
+        }
+
+        bool stride = (this->pyramid_method_ == "stride");
+
+        for (int l=1; l<=this->pyramid_levels_; l++) {
+            Halve_box(stride, origin, extent, sum, count);
+
+            num_points = sum.size();
+
+            if (!stride)
+                for (hsize_t p=0; p<num_points; p++)
+                    sum[p] /= count[p];
+
+            hid_t level = H5Dopen2(this->parent_->id(), this->level_name(l).c_str(), H5P_DEFAULT);
+            hid_t filespace = H5Dget_space(level);
+            hid_t level_memoryspace = H5Screate_simple(nD, extent.data(), NULL);
+
+            if (num_points > 0)
+                H5Sselect_hyperslab(filespace, H5S_SELECT_SET, origin.data(), NULL, extent.data(), NULL);
+            else {
+                H5Sselect_none(filespace);
+                H5Sselect_none(level_memoryspace);
+            }
+
+            H5Dwrite(level, H5T_NATIVE_DOUBLE, level_memoryspace, filespace, H5P_DEFAULT, sum.data());
+
+            H5Sclose(level_memoryspace);
+            H5Sclose(filespace);
+            H5Dclose(level);
+
+            //Back to sums for the next level
+            if (!stride)
+                for (hsize_t p=0; p<num_points; p++)
+                    sum[p] *= count[p];
+        }
+    }
+
+    //Hash of n bytes continuing from hash, 8 bytes at a time
+    static unsigned long long Hash_bytes(unsigned long long hash, const char *bytes, size_t n) {
+        const unsigned long long prime = 0x9E3779B97F4A7C15ULL;
+
+        size_t i = 0;
+        for (; i+8<=n; i+=8) {
+            unsigned long long word;
+            memcpy(&word, bytes+i, 8);
+            hash = (hash ^ word)*prime;
+            hash ^= hash >> 29;
+        }
+
+        for (; i<n; i++) {
+            hash = (hash ^ (unsigned char)bytes[i])*prime;
+            hash ^= hash >> 29;
+        }
+
+        return hash;
+    }
+
+    /**
+     * Write only the chunks whose data changed since the previous write through this Dataset.
+     * Each process keeps a 64 bit hash of its part of every chunk its box touches, and the
+     * selections of a write are narrowed to the parts whose hash differs. Meant for state that
+     * changes little between checkpoints. Hashes are reset when the plan's box changes; data
+     * written to the dataset by other means is not noticed. Needs a chunked dataset and plans
+     * with single box selections, other plans are written in full.
+     */
+    Dataset &Dataset::set_incremental(bool incremental) {
+        this->incremental_chunk_.clear();
+        this->hashed_box_.clear();
+        this->chunk_hashes_.clear();
+
+        if (!incremental)
+            return *this;
+
+        hid_t dcpl = H5Dget_create_plist(this->id_);
+
+        if (H5Pget_layout(dcpl) == H5D_CHUNKED) {
+            this->incremental_chunk_.resize(this->shape_.size());
+            H5Pget_chunk(dcpl, this->shape_.size(), this->incremental_chunk_.data());
+        }
+        else
+            std::cerr << "Dataset::set_incremental: " << this->name_ << " is not chunked, writes stay full" << std::endl;
+
+        H5Pclose(dcpl);
+        return *this;
+    }
+
+    bool Dataset::isIncremental() const {
+        return !this->incremental_chunk_.empty();
+    }
+
+    static void Append_hook_(std::string &hooks, const char *hook) {
+        hooks += (hooks.empty() ? "" : ", ");
+        hooks += hook;
+    }
+
+    //Write-time features set on the dataset that only write() and operator<< keep up to date,
+    //empty if none. Batch and append() refuse to write datasets with any of them.
+    std::string Dataset::write_hooks(bool with_statistics) const {
+        std::string hooks;
+
+        if (with_statistics && this->statistics_bins_ >= 0)
+            Append_hook_(hooks, "write statistics");
+        if (this->hasMinmaxIndex())
+            Append_hook_(hooks, "a min/max index");
+        if (this->hasPyramid())
+            Append_hook_(hooks, "pyramid levels");
+        if (this->isIncremental())
+            Append_hook_(hooks, "incremental writes");
+        if (this->significant_bits_ >= 0)
+            Append_hook_(hooks, "rounding to significant bits");
+
+        return hooks;
+    }
+
+    //Whether writes must go through write() with the plan's own memoryspace
+    bool Dataset::needsBoxWrite() const {
+        return !this->write_hooks(false).empty();
+    }
+
+    //Hash the parts of the chunks in the plan's box and select the changed ones in new copies of
+    //memoryspace and filespace. Returns false, leaving the selections alone, when the write is full.
+    bool Dataset::select_changed_chunks(hid_t dtype, const void *data, hid_t &memoryspace, hid_t &filespace) const {
+        if (this->incremental_chunk_.empty())
+            return false;
+
+        int nD = this->shape_.size();
+        int last = nD-1;
+        const std::vector<hsize_t> &chunk = this->incremental_chunk_;
+
+        std::vector<hsize_t> memoryspace_start, filespace_start, count, filespace_count;
+
+        if (!Get_box(memoryspace, memoryspace_start, count) || !Get_box(filespace, filespace_start, filespace_count) || count != filespace_count)
+            return false;
+
+        hsize_t num_points = 1;
+        for (int d=0; d<nD; d++)
+            num_points *= count[d];
+
+        if (num_points == 0)
+            return false;
+
+        std::vector<hsize_t> box(filespace_start);
+        box.insert(box.end(), count.begin(), count.end());
+
+        if (box != this->hashed_box_) {
+            this->hashed_box_ = box;
+            this->chunk_hashes_.clear();
+        }
+
+        std::vector<hsize_t> extent(nD), first_chunk(nD), num_chunks(nD);
+        H5Sget_simple_extent_dims(memoryspace, extent.data(), NULL);
+
+        hsize_t total_chunks = 1;
+        for (int d=0; d<nD; d++) {
+            first_chunk[d] = filespace_start[d]/chunk[d];
+            num_chunks[d] = (filespace_start[d] + count[d] - 1)/chunk[d] - first_chunk[d] + 1;
+            total_chunks *= num_chunks[d];
+        }
+
+        size_t dtype_size = H5Tget_size(dtype);
+        const char *bytes = static_cast<const char*>(data);
+
+        std::vector<unsigned long long> hashes(total_chunks);
+        std::vector<hsize_t> c(nD, 0), start(nD), part(nD), memory_start(nD), row(nD);
+
+        hid_t changed_memoryspace = H5Scopy(memoryspace);
+        hid_t changed_filespace = H5Scopy(filespace);
+        H5Sselect_none(changed_memoryspace);
+        H5Sselect_none(changed_filespace);
+
+        hsize_t num_changed = 0;
+
+        for (hsize_t k=0; k<total_chunks; k++) {
+            //Part of chunk first_chunk + c inside the box
+            hsize_t part_rows = 1;
+            for (int d=0; d<nD; d++) {
+                hsize_t chunk_start = (first_chunk[d] + c[d])*chunk[d];
+                start[d] = std::max(chunk_start, filespace_start[d]);
+                part[d] = std::min(chunk_start + chunk[d], filespace_start[d] + count[d]) - start[d];
+                memory_start[d] = memoryspace_start[d] + start[d] - filespace_start[d];
+                if (d < last)
+                    part_rows *= part[d];
+            }
+
+            unsigned long long hash = 0xCBF29CE484222325ULL;
+            std::fill(row.begin(), row.end(), 0);
+
+            for (hsize_t r=0; r<part_rows; r++) {
+                hsize_t offset = 0;
+                for (int d=0; d<last; d++)
+                    offset = offset*extent[d] + memory_start[d] + row[d];
+                offset = offset*extent[last] + memory_start[last];
+
+                hash = Hash_bytes(hash, bytes + offset*dtype_size, part[last]*dtype_size);
+
+                for (int d=last-1; d>=0; d--) {
+                    if (++row[d] < part[d])
+                        break;
+                    row[d] = 0;
+                }
+            }
+
+            hashes[k] = hash;
+
+            if (this->chunk_hashes_.empty() || this->chunk_hashes_[k] != hash) {
+                H5Sselect_hyperslab(changed_filespace, H5S_SELECT_OR, start.data(), NULL, part.data(), NULL);
+                H5Sselect_hyperslab(changed_memoryspace, H5S_SELECT_OR, memory_start.data(), NULL, part.data(), NULL);
+                num_changed++;
+            }
+
+            for (int d=last; d>=0; d--) {
+                if (++c[d] < num_chunks[d])
+                    break;
+                c[d] = 0;
+            }
+        }
+
+        this->chunk_hashes_.swap(hashes);
+
+        if (num_changed == total_chunks) {
+            H5Sclose(changed_memoryspace);
+            H5Sclose(changed_filespace);
+            return false;
+        }
+
+        memoryspace = changed_memoryspace;
+        filespace = changed_filespace;
+        return true;
+    }
+
+    /**
+     * Keep only 'bits' explicit mantissa bits of floating point data written through this Dataset,
+     * rounding to nearest (bit grooming). The trailing bits become zeros, which the shuffle and
+     * deflate filters compress well. The relative error is at most 2^-(bits+1). The setting is
+     * recorded in the attribute "significant_bits", a negative value turns rounding off.
+     */
+    Dataset &Dataset::set_significant_bits(int bits) {
+        this->significant_bits_ = (bits < 0 ? -1 : bits);
+
+        if (bits >= 0)
+            write_attribute(this->id_, "significant_bits", bits);
+        else if (has_attribute(this->id_, "significant_bits"))
+            H5Adelete(this->id_, "significant_bits");
+
+        return *this;
+    }
+
+    //Mantissa bits for 'digits' significant decimal digits
+    Dataset &Dataset::set_significant_digits(int digits) {
+        return this->set_significant_bits(digits < 0 ? -1 : int(ceil(digits*3.321928094887362)));
+    }
+
+    //Store the process grid of the plan, set_restart_plan() keeps it when the process count is unchanged
+    Dataset &Dataset::write_decomposition() {
+        write_attribute(this->id_, "decomposition", this->plan.numprocs());
+        return *this;
+    }
+
+    //Process grid stored by write_decomposition(), empty when none was stored
+    std::vector<int> Dataset::decomposition() const {
+        std::vector<int> numprocs;
+
+        if (has_attribute(this->id_, "decomposition"))
+            read_attribute(this->id_, "decomposition", numprocs);
+
+        return numprocs;
+    }
+
+    /**
+     * Plan for restarting from this dataset with any number of processes. The stored process grid
+     * is kept when it has as many processes as the communicator, else the leading 'split_dims'
+     * dimensions, as many as the stored grid divided or 1 by default, get a balanced grid from
+     * MPI_Dims_create. Further dimensions are split when a dimension would get more processes
+     * than elements. Each process reads its block of the grid, the extents need not divide evenly.
+     * A half-spectrum keeps its last dimension unsplit and its memory holding the full extent, as
+     * in the default plan, so set_hermitian_reconstruction() applies. The plan is left as it is
+     * when no grid fits.
+     */
+    Dataset &Dataset::set_restart_plan(int split_dims) {
+        int nD = this->shape_.size();
+        int my_rank = 0, size = 1;
+
+#ifdef H5SI_ENABLE_MPI
+        if (this->driver_ == "mpio") {
+            MPI_Comm_rank(this->MPI_COMMUNICATOR, &my_rank);
+            MPI_Comm_size(this->MPI_COMMUNICATOR, &size);
+        }
+#endif
+
+        std::vector<int> numprocs = this->decomposition();
+        numprocs.resize(nD, 1);
+
+        //Dimensions that may be split, all but the last of a half-spectrum
+        int max_split_dims = (this->isHermitian() ? nD-1 : nD);
+
+        int stored_size = 1, stored_split_dims = 0;
+        for (int d=0; d<nD; d++) {
+            stored_size *= numprocs[d];
+            if (numprocs[d] > 1)
+                stored_split_dims = d+1;
+        }
+
+        if (stored_size != size || stored_split_dims > max_split_dims) {
+            if (split_dims <= 0)
+                split_dims = std::max(stored_split_dims, 1);
+            split_dims = std::max(std::min(split_dims, max_split_dims), 1);
+
+            //More dimensions are split while the grid has more processes than elements along one
+            bool fits = false;
+
+            for (; split_dims<=max_split_dims && !fits; split_dims++) {
+                std::vector<int> dims(split_dims, 0);
+#ifdef H5SI_ENABLE_MPI
+                MPI_Dims_create(size, split_dims, dims.data());
+#else
+                std::fill(dims.begin(), dims.end(), 1);
+#endif
+
+                //Largest process counts along the longest of the split dimensions
+                std::vector< std::pair<hsize_t, int> > extents(split_dims);
+                for (int d=0; d<split_dims; d++)
+                    extents[d] = std::make_pair(this->shape_[d], d);
+
+                std::sort(extents.rbegin(), extents.rend());
+                std::sort(dims.rbegin(), dims.rend());
+
+                std::fill(numprocs.begin(), numprocs.end(), 1);
+                fits = true;
+
+                for (int i=0; i<split_dims; i++) {
+                    numprocs[extents[i].second] = dims[i];
+                    fits = fits && hsize_t(dims[i]) <= extents[i].first;
+                }
+            }
+
+            if (!fits) {
+                std::cerr << "Dataset::set_restart_plan: " << size << " processes can not be laid out over " << this->name_ << " without empty blocks" << std::endl;
+                return *this;
+            }
+        }
+
+        //Row major position of this process in the grid
+        std::vector<int> my_id(nD);
+        for (int d=nD-1, rest=my_rank; d>=0; d--) {
+            my_id[d] = rest % numprocs[d];
+            rest /= numprocs[d];
+        }
+
+        std::vector<hsize_t> memory_shape = this->shape_;
+        if (this->isHermitian())
+            memory_shape[nD-1] = this->hermitian_extent_;
+
+        this->plan.set_block_plan(my_id, numprocs, memory_shape, this->shape_);
+        this->default_plan_ = false;
+        return *this;
+    }
+
+    //Owned block of this process under the plan's decomposition, start and count along each dimension
+    static void Owned_block_(const Plan &plan, const std::vector<hsize_t> &shape, std::vector<hsize_t> &start, std::vector<hsize_t> &count) {
+        int nD = shape.size();
+        std::vector<int> my_id = plan.my_id();
+        std::vector<int> numprocs = plan.numprocs();
+
+        start.resize(nD);
+        count.resize(nD);
+
+        for (int d=0; d<nD; d++) {
+            int id = (d < int(my_id.size()) ? my_id[d] : 0);
+            int np = (d < int(numprocs.size()) ? numprocs[d] : 1);
+
+            start[d] = id*shape[d]/np;
+            count[d] = (id+1)*shape[d]/np - start[d];
+        }
+    }
+
+    //Shape of the local array of read_halo(), the owned block with 'ghost' layers on both sides
+    std::vector<hsize_t> Dataset::halo_shape(std::vector<hsize_t> ghost) const {
+        std::vector<hsize_t> start, count;
+        Owned_block_(this->plan, this->shape_, start, count);
+
+        for (std::vector<hsize_t>::size_type d=0; d<count.size() && d<ghost.size(); d++)
+            count[d] += 2*ghost[d];
+
+        return count;
+    }
+
+    /**
+     * Read this process's block of the plan's decomposition, the leading dimension divided among
+     * the processes by default, together with ghost[d] layers of the neighbouring blocks on both
+     * sides along each dimension d, into the array 'data' of shape halo_shape(ghost). Along
+     * periodic dimensions the layers beyond the ends of the dataset wrap around, along the others
+     * they are left as they are. Each combination of the parts before, inside and after the
+     * dataset along the dimensions is read with its own pair of hyperslabs, straight from the
+     * file, so no halo exchange is needed after a restart.
+     */
+    herr_t Dataset::read_halo(hid_t dtype, void *data, std::vector<hsize_t> ghost, std::vector<bool> periodic) const {
+        int nD = this->shape_.size();
+
+        ghost.resize(nD, 0);
+        periodic.resize(nD, false);
+
+        std::vector<hsize_t> start, count;
+        Owned_block_(this->plan, this->shape_, start, count);
+
+        std::vector<hsize_t> padded = this->halo_shape(ghost);
+
+        //Parts along each dimension: memory offset, file offset and length
+        struct Part { hsize_t memory, file, length; };
+        std::vector< std::vector<Part> > parts(nD);
+
+        for (int d=0; d<nD; d++) {
+            hsize_t N = this->shape_[d];
+
+            if (periodic[d] && ghost[d] > N) {
+                std::cerr << "Dataset::read_halo: " << ghost[d] << " ghost layers along dimension " << d << " of " << this->name_ << " exceed its extent " << N << std::endl;
+                return -1;
+            }
+
+            //Global indices start-ghost .. start+count+ghost-1, signed as they may fall outside [0, N)
+            long long low = (long long)start[d] - (long long)ghost[d];
+            long long high = (long long)(start[d] + count[d] + ghost[d]);
+
+            long long inside_low = std::max(low, 0LL);
+            long long inside_high = std::min(high, (long long)N);
+
+            if (low < 0 && periodic[d]) {
+                Part part = {0, hsize_t(N + low), hsize_t(-low)};
+                parts[d].push_back(part);
+            }
+
+            if (inside_low < inside_high) {
+                Part part = {hsize_t(inside_low - low), hsize_t(inside_low), hsize_t(inside_high - inside_low)};
+                parts[d].push_back(part);
+            }
+
+            if (high > (long long)N && periodic[d]) {
+                Part part = {hsize_t((long long)N - low), 0, hsize_t(high - (long long)N)};
+                parts[d].push_back(part);
+            }
+        }
+
+        size_t num_combinations = 1;
+        for (int d=0; d<nD; d++)
+            num_combinations *= parts[d].size();
+
+        std::vector<hsize_t> memory_start(nD), file_start(nD), length(nD);
+        herr_t status = 0;
+
+        for (size_t c=0; c<num_combinations; c++) {
+            size_t rest = c;
+            for (int d=nD-1; d>=0; d--) {
+                const Part &part = parts[d][rest % parts[d].size()];
+                rest /= parts[d].size();
+
+                memory_start[d] = part.memory;
+                file_start[d] = part.file;
+                length[d] = part.length;
+            }
+
+            hid_t memoryspace = H5Screate_simple(nD, padded.data(), NULL);
+            hid_t filespace = H5Dget_space(this->id_);
+
+            H5Sselect_hyperslab(memoryspace, H5S_SELECT_SET, memory_start.data(), NULL, length.data(), NULL);
+            H5Sselect_hyperslab(filespace, H5S_SELECT_SET, file_start.data(), NULL, length.data(), NULL);
+
+            if (this->transfer(false, dtype, memoryspace, filespace, data) < 0)
+                status = -1;
+
+            H5Sclose(memoryspace);
+            H5Sclose(filespace);
+        }
+
+        return status;
+    }
+
+    bool Dataset::isHermitian() const {
+        return (this->hermitian_extent_ > 0);
+    }
+
+    //Extent of the last dimension of the full spectrum, 0 if the dataset is not a half-spectrum
+    hsize_t Dataset::hermitian_extent() const {
+        return this->hermitian_extent_;
+    }
+
+    /**
+     * Fill in the redundant half of a half-spectrum on read, see DatasetOptions::hermitian().
+     * Element [k0, .., kz] with kz > N/2 is the conjugate of [-k0, .., N-kz], indices modulo the
+     * extents. The conjugates are read from file with a second selection, so a process needs no
+     * data of the others. Assumes the memory of the plan holds the full last dimension, as the
+     * default plan does, and a complex datatype of two floating point members.
+     */
+    Dataset &Dataset::set_hermitian_reconstruction(bool reconstruct) {
+        if (reconstruct && !this->isHermitian())
+            std::cerr << "Dataset::set_hermitian_reconstruction: " << this->name_ << " is not a half-spectrum" << std::endl;
+
+        this->hermitian_reconstruction_ = reconstruct && this->isHermitian();
+        return *this;
+    }
+
+    void Dataset::reconstruct_hermitian(hid_t dtype, void *data) const {
+        int nD = this->shape_.size();
+        int last = nD-1;
+        hsize_t N = this->hermitian_extent_;
+        hsize_t M = N - this->shape_[last];        // Redundant elements along the last dimension
+
+        std::vector<hsize_t> global = this->plan.memoryspace_dimension();
+        std::vector<int> numprocs = this->plan.numprocs();
+
+        if (M == 0 || int(global.size()) != nD || global[last] != N || numprocs[last] != 1)
+            return;
+
+        //Conjugation flips the sign bit of the second member
+        if (H5Tget_class(dtype) != H5T_COMPOUND || H5Tget_nmembers(dtype) != 2) {
+            std::cerr << "Dataset::reconstruct_hermitian: " << this->name_ << " is not read as a complex datatype" << std::endl;
+            return;
+        }
+
+        hid_t imag = H5Tget_member_type(dtype, 1);
+        size_t sign_position = 0;
+        bool is_float = (H5Tget_class(imag) == H5T_FLOAT);
+
+        if (is_float)
+            H5Tget_fields(imag, &sign_position, NULL, NULL, NULL, NULL);
+
+        size_t sign_byte = (H5Tget_order(imag) == H5T_ORDER_BE ? H5Tget_size(imag)-1 - sign_position/8 : sign_position/8);
+        sign_byte += H5Tget_member_offset(dtype, 1);
+        unsigned char sign_mask = (unsigned char)(1 << (sign_position%8));
+        H5Tclose(imag);
+
+        if (!is_float) {
+            std::cerr << "Dataset::reconstruct_hermitian: " << this->name_ << " is not read as a complex datatype" << std::endl;
+            return;
+        }
+
+        //Mirrors of the local indices along each dimension but the last, sorted, and the position of
+        //the mirror of each local index among them
+        std::vector<hsize_t> count(nD);
+        std::vector< std::vector<hsize_t> > mirrors(last), position(last);
+        hsize_t num_rows = 1;
+
+        //The block of this process, uneven under a block plan
+        std::vector<hsize_t> block_start, block_count;
+        Owned_block_(this->plan, global, block_start, block_count);
+
+        for (int d=0; d<last; d++) {
+            hsize_t start = block_start[d];
+            count[d] = block_count[d];
+
+            for (hsize_t i=0; i<count[d]; i++)
+                mirrors[d].push_back((global[d] - (start + i)) % global[d]);
+
+            std::vector<hsize_t> sorted = mirrors[d];
+            std::sort(sorted.begin(), sorted.end());
+
+            position[d].resize(count[d]);
+            for (hsize_t i=0; i<count[d]; i++)
+                position[d][i] = std::lower_bound(sorted.begin(), sorted.end(), mirrors[d][i]) - sorted.begin();
+
+            mirrors[d] = sorted;
+            num_rows *= count[d];
+        }
+        count[last] = M;
+
+        //The mirrors form at most two runs per dimension, their product is selected in file
+        hid_t filespace = H5Dget_space(this->id_);
+        H5Sselect_none(filespace);
+
+        std::vector< std::vector< std::pair<hsize_t, hsize_t> > > runs(last);
+        size_t num_combinations = 1;
+
+        for (int d=0; d<last; d++) {
+            for (hsize_t i=0; i<mirrors[d].size(); i++) {
+                if (i > 0 && mirrors[d][i] == mirrors[d][i-1] + 1)
+                    runs[d].back().second++;
+                else
+                    runs[d].push_back(std::make_pair(mirrors[d][i], hsize_t(1)));
+            }
+            num_combinations *= runs[d].size();
+        }
+
+        std::vector<hsize_t> run_start(nD), run_count(nD);
+        run_start[last] = 1;
+        run_count[last] = M;
+
+        for (size_t c=0; c<num_combinations; c++) {
+            size_t rest = c;
+            for (int d=last-1; d>=0; d--) {
+                run_start[d] = runs[d][rest % runs[d].size()].first;
+                run_count[d] = runs[d][rest % runs[d].size()].second;
+                rest /= runs[d].size();
+            }
+            H5Sselect_hyperslab(filespace, H5S_SELECT_OR, run_start.data(), NULL, run_count.data(), NULL);
+        }
+
+        size_t size = H5Tget_size(dtype);
+        std::vector<char> conjugates(num_rows*M*size);
+
+        hid_t memoryspace = H5Screate_simple(nD, count.data(), NULL);
+        herr_t status = H5Dread(this->id_, dtype, memoryspace, filespace, H5P_DEFAULT, conjugates.data());
+        H5Sclose(memoryspace);
+        H5Sclose(filespace);
+
+        if (status < 0)
+            return;
+
+        //Element [r.., kz] of data is the conjugate of [position(r).., N-kz-1] of conjugates
+        char *out = static_cast<char*>(data);
+
+        for (hsize_t r=0; r<num_rows; r++) {
+            hsize_t rest = r, mirror_row = 0, stride = 1;
+            for (int d=last-1; d>=0; d--) {
+                mirror_row += position[d][rest % count[d]]*stride;
+                stride *= count[d];
+                rest /= count[d];
+            }
+
+            for (hsize_t kz=N-M; kz<N; kz++) {
+                char *element = out + (r*N + kz)*size;
+                memcpy(element, &conjugates[(mirror_row*M + N-kz-1)*size], size);
+                element[sign_byte] ^= sign_mask;
+            }
+        }
+    }
+
+    //Whether extent matches the shape of the plan's memoryspace
+    bool isShapeEqual(const Plan &plan, std::vector<hsize_t> extent) {
+        int nD = H5Sget_simple_extent_ndims(plan.memoryspace());
+
+        if (nD != int(extent.size()))
+            return false;
+
+        std::vector<hsize_t> dimension(nD);
+        H5Sget_simple_extent_dims(plan.memoryspace(), dimension.data(), NULL);
+
+        return (dimension == extent);
     }
 
     const Dataset &operator>>(const Dataset &ds, void *data) {
-        H5Dread(ds.id(), H5Tget_native_type(ds.dtype(), H5T_DIR_ASCEND), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        hid_t native_dtype = Convert::native_dtype(ds.dtype());
+        ds.read(native_dtype, data);
+        H5Tclose(native_dtype);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const void *data) {
-        H5Dwrite(ds.id(), H5Tget_native_type(ds.dtype(), H5T_DIR_ASCEND), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        hid_t native_dtype = Convert::native_dtype(ds.dtype());
+        ds.write(native_dtype, data);
+        H5Tclose(native_dtype);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, char *data) {
-        H5Dread(ds.id(), Dtype("char"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("char"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const char *data) {
-        H5Dwrite(ds.id(), Dtype("char"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("char"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, signed char *data) {
-        H5Dread(ds.id(), Dtype("schar"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("schar"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const signed char *data) {
-        H5Dwrite(ds.id(), Dtype("schar"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("schar"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, unsigned char *data) {
-        H5Dread(ds.id(), Dtype("uchar"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("uchar"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const unsigned char *data) {
-        H5Dwrite(ds.id(), Dtype("uchar"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("uchar"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, short *data) {
-        H5Dread(ds.id(), Dtype("short"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("short"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const short *data) {
-        H5Dwrite(ds.id(), Dtype("short"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("short"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, unsigned short *data) {
-        H5Dread(ds.id(), Dtype("ushort"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("ushort"), data);
         return ds;
 
     }
     const Dataset &operator<<(const Dataset &ds, const unsigned short *data) {
-        H5Dwrite(ds.id(), Dtype("ushort"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("ushort"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, int *data) {
-        H5Dread(ds.id(), Dtype("int"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("int"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const int *data) {
-        H5Dwrite(ds.id(), Dtype("int"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("int"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, unsigned int *data) {
-        H5Dread(ds.id(), Dtype("uint"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("uint"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const unsigned int *data) {
-        H5Dwrite(ds.id(), Dtype("uint"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("uint"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, long *data) {
-        H5Dread(ds.id(), Dtype("long"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("long"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const long *data) {
-        H5Dwrite(ds.id(), Dtype("long"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("long"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, unsigned long *data) {
-        H5Dread(ds.id(), Dtype("ulong"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("ulong"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const unsigned long *data) {
-        H5Dwrite(ds.id(), Dtype("ulong"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("ulong"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, long long *data) {
-        H5Dread(ds.id(), Dtype("llong"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("llong"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const long long *data) {
-        H5Dwrite(ds.id(), Dtype("llong"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("llong"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, unsigned long long *data) {
-        H5Dread(ds.id(), Dtype("ullong"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("ullong"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const unsigned long long *data) {
-        H5Dwrite(ds.id(), Dtype("ullong"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("ullong"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, float *data) {
-        H5Dread(ds.id(), Dtype("float"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("float"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const float *data) {
-        H5Dwrite(ds.id(), Dtype("float"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("float"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, std::complex<float> *data) {
-        H5Dread(ds.id(), Dtype("cfloat"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("cfloat"), data);
         return ds;
     }
 
     const Dataset &operator<<(const Dataset &ds, const std::complex<float> *data) {
-        H5Dwrite(ds.id(), Dtype("cfloat"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("cfloat"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, double *data) {
-        H5Dread(ds.id(), Dtype("double"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("double"), data);
         return ds;
 
     }
 
     const Dataset &operator<<(const Dataset &ds, const std::complex<double> *data) {
-        H5Dwrite(ds.id(), Dtype("cdouble"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("cdouble"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, std::complex<double> *data) {
-        H5Dread(ds.id(), Dtype("cdouble"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("cdouble"), data);
         return ds;
 
     }
 
     const Dataset &operator<<(const Dataset &ds, const double *data) {
-        H5Dwrite(ds.id(), Dtype("double"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("double"), data);
         return ds;
     }
 
     const Dataset &operator>>(const Dataset &ds, long double *data) {
-        H5Dread(ds.id(), Dtype("ldouble"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.read(Dtype("ldouble"), data);
         return ds;
 
     }
     const Dataset &operator<<(const Dataset &ds, const long double *data) {
-        H5Dwrite(ds.id(), Dtype("ldouble"), ds.plan.memoryspace(), ds.plan.filespace(), H5P_DEFAULT, data);
+        ds.write(Dtype("ldouble"), data);
         return ds;
     }
 
@@ -50,11 +50,15 @@
 #include <dirent.h>
 
 #include <map>
+#include <iostream>
 
 #include <complex>
 
 #include "h5plan.h"
 #include "h5datatype.h"
+#include "h5options.h"
+#include "h5select.h"
+#include "h5reduce.h"
 
 namespace h5 {
 
@@ -75,6 +79,66 @@ namespace h5 {
 
         std::string driver_;
 
+        std::vector<char> append_buffer_;       // Records buffered by append(), written in one go by flush()
+        hsize_t append_buffer_records_;         // Capacity of append_buffer_ in records, 0 if the dataset is not extendable
+        hsize_t num_buffered_records_;
+
+        mutable std::vector<char> staging_;     // Converted copy of the data when memory and file datatypes differ
+
+        size_t chunk_cache_nslots_;             // Raw data chunk cache parameters, used only when
+        size_t chunk_cache_nbytes_;             // chunk_cache_nbytes_ > 0, see set_chunk_cache()
+        double chunk_cache_w0_;
+
+        int statistics_bins_;                   // Histogram bins of the write statistics, -1 for none, see set_statistics()
+        std::vector<double> statistics_range_;  // Range of the histogram bins, empty without a histogram
+
+        void update_statistics(hid_t dtype, hid_t memoryspace, const void *data, herr_t status) const;
+        void store_statistics(Moments &moments, Histogram &histogram, herr_t status) const;
+
+        std::vector<hsize_t> index_block_;      // Block shape of the min/max index, empty for none, see set_minmax_index()
+
+        std::string index_name() const;
+        bool isIndexable(const Plan &plan) const;
+        void build_minmax_index() const;
+
+        int pyramid_levels_;                    // Downsampled levels written next to the dataset, see set_pyramid()
+        std::string pyramid_method_;
+
+        std::vector<hsize_t> incremental_chunk_;            // Chunk shape of incremental writes, empty if off, see set_incremental()
+        mutable std::vector<hsize_t> hashed_box_;           // Start and count of the file box the hashes are of
+        mutable std::vector<unsigned long long> chunk_hashes_;   // Hash of the part of each chunk of the box written last
+
+        bool select_changed_chunks(hid_t dtype, const void *data, hid_t &memoryspace, hid_t &filespace) const;
+
+        int significant_bits_;                  // Mantissa bits kept on write, -1 for all, see set_significant_bits()
+
+        hsize_t hermitian_extent_;              // Full extent of the last dimension of a half-spectrum, 0 if not one
+        bool hermitian_reconstruction_;         // Fill the redundant half on read, see set_hermitian_reconstruction()
+
+        void reconstruct_hermitian(hid_t dtype, void *data) const;
+
+        static size_t max_transfer_size_;       // Bytes moved by one H5Dread/H5Dwrite at most, see transfer()
+
+        herr_t transfer(bool is_write, hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const;
+        static herr_t transfer(hid_t dataset, hid_t dxpl, bool is_write, hid_t dtype, hid_t memoryspace, hid_t filespace, void *data);
+        static bool fits_transfer(hid_t dataset, hid_t dtype, hid_t memoryspace);
+
+        static size_t two_phase_run_size_;      // Mean file run in bytes below which reads are two-phase, see read_selection()
+        bool two_phase_;                        // Reads may be two-phase and are collective, see set_two_phase()
+
+        herr_t read_selection(hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const;
+        bool prefers_two_phase(hid_t dtype, hid_t filespace) const;
+        herr_t read_two_phase(hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const;
+
+        hid_t create_dapl() const;
+
+        bool default_plan_;                     // The plan is set_default_plan()'s, rebuilt as the dataset grows
+
+        void set_default_plan();
+        void write_records(const void *data, hsize_t num_records);
+
+        friend class Batch;
+
     public:
 
 #ifdef H5SI_ENABLE_MPI
@@ -85,8 +149,9 @@ namespace h5 {
         Dataset();
         Dataset(const Dataset& ds);
         Dataset(Group *parent, std::string name);
-        Dataset(Group *parent, std::string name, std::vector<hsize_t> shape, std::string data_type);
-        Dataset(Group *parent, std::string name, Plan plan, std::string data_type="");
+        Dataset(Group *parent, std::string name, std::vector<hsize_t> shape, std::string data_type, DatasetOptions options=DatasetOptions());
+        Dataset(Group *parent, std::string name, Plan plan, std::string data_type="", DatasetOptions options=DatasetOptions());
+        Dataset(Group *parent, std::string name, std::vector<hsize_t> record_shape, std::string data_type, hsize_t buffer_records, DatasetOptions options=DatasetOptions());
 
         ~Dataset();
 
@@ -103,8 +168,69 @@ namespace h5 {
         std::string driver() const;
         std::vector<hsize_t> shape() const;
 
+        bool isExtendable() const;
+        size_t record_size() const;
+
+        herr_t read(hid_t dtype, void *data) const;
+        herr_t write(hid_t dtype, const void *data) const;
+
+        herr_t read(hid_t dtype, hid_t memoryspace, hid_t filespace, void *data) const;
+        herr_t write(hid_t dtype, hid_t memoryspace, hid_t filespace, const void *data) const;
+
+        static void set_max_transfer_size(size_t bytes);
+        static void set_two_phase_run_size(size_t bytes);
+        Dataset &set_two_phase(bool two_phase=true);
+
+        Dataset &append(const void *data, hsize_t num_records=1);
+        void flush();
+
         Dataset &set_plan(Plan plan);
 
+        Dataset &write_decomposition();
+        std::vector<int> decomposition() const;
+        Dataset &set_restart_plan(int split_dims=0);
+
+        Dataset &set_chunk_cache(size_t nslots, size_t nbytes, double w0=0.75);
+        Dataset &auto_chunk_cache(size_t max_nbytes=268435456);
+
+        double reduce(std::string op, size_t memory_budget=67108864) const;
+        double reduce(std::string op, Select select, size_t memory_budget=67108864) const;
+        void reduce(Reduction &reduction, Select select, size_t memory_budget=67108864) const;
+
+        Dataset &set_statistics(int histogram_bins=0, double histogram_min=0, double histogram_max=0);
+
+        Dataset &set_minmax_index(std::vector<hsize_t> block=std::vector<hsize_t>());
+        bool hasMinmaxIndex() const;
+        void update_minmax_index(hid_t dtype, hid_t memoryspace, const void *data) const;
+        Expression candidates(std::string op, double value) const;
+        std::vector<double> query(std::string op, double value, Expression &blocks) const;
+
+        Dataset &set_pyramid(int levels, std::string method="stride");
+        bool hasPyramid() const;
+        std::string level_name(int level) const;
+        void update_pyramid(hid_t dtype, hid_t memoryspace, const void *data) const;
+
+        Dataset &set_incremental(bool incremental=true);
+        bool isIncremental() const;
+
+        bool needsBoxWrite() const;
+        std::string write_hooks(bool with_statistics=true) const;
+
+        Dataset &set_significant_bits(int bits);
+        Dataset &set_significant_digits(int digits);
+
+        std::vector<hsize_t> halo_shape(std::vector<hsize_t> ghost) const;
+        herr_t read_halo(hid_t dtype, void *data, std::vector<hsize_t> ghost, std::vector<bool> periodic=std::vector<bool>()) const;
+
+        template<typename T>
+        herr_t read_halo(T *data, std::vector<hsize_t> ghost, std::vector<bool> periodic=std::vector<bool>()) const {
+            return this->read_halo(Dtype(NativeDtype<T>::name()), data, ghost, periodic);
+        }
+
+        bool isHermitian() const;
+        hsize_t hermitian_extent() const;
+        Dataset &set_hermitian_reconstruction(bool reconstruct=true);
+
         const Dataset &operator=(const Dataset &dataset);
     };
 
@@ -143,6 +269,69 @@ namespace h5 {
     const Dataset &operator>>(const Dataset &ds, long double *data);
     const Dataset &operator<<(const Dataset &ds, const long double *data);
 
+    bool isShapeEqual(const Plan &plan, std::vector<hsize_t> extent);
+
+    //Read into / write from a blitz array, which may be a non-contiguous view (slice, strided
+    //subarray). The memory dataspace is derived from the array's strides so that the view is
+    //accessed in place. Views that can not be described by a strided dataspace (reversed ranks,
+    //non C storage order) go through a contiguous temporary. Either way the elements are converted
+    //through the staging buffer of Dataset::read() and write().
+    template<typename T, int N>
+    const Dataset &operator>>(const Dataset &ds, blitz::Array<T,N> A) {
+        std::vector<hsize_t> extent(N);
+        std::vector<hssize_t> stride(N);
+
+        for (int d=0; d<N; d++) {
+            extent[d] = A.extent(d);
+            stride[d] = A.stride(d);
+        }
+
+        if (!isShapeEqual(ds.plan, extent)) {
+            std::cerr << "Dataset::operator>>: Array shape does not match the memory space of the plan of " << ds.name() << std::endl;
+            return ds;
+        }
+
+        hid_t memoryspace = (ds.isHermitian() ? -1 : ds.plan.memoryspace(stride));
+
+        if (memoryspace < 0) {
+            blitz::Array<T,N> contiguous(A.shape());
+            ds >> contiguous.data();
+            A = contiguous;
+            return ds;
+        }
+
+        ds.read(Dtype(NativeDtype<T>::name()), memoryspace, ds.plan.filespace(), A.data());
+        H5Sclose(memoryspace);
+        return ds;
+    }
+
+    template<typename T, int N>
+    const Dataset &operator<<(const Dataset &ds, const blitz::Array<T,N> &A) {
+        std::vector<hsize_t> extent(N);
+        std::vector<hssize_t> stride(N);
+
+        for (int d=0; d<N; d++) {
+            extent[d] = A.extent(d);
+            stride[d] = A.stride(d);
+        }
+
+        if (!isShapeEqual(ds.plan, extent)) {
+            std::cerr << "Dataset::operator<<: Array shape does not match the memory space of the plan of " << ds.name() << std::endl;
+            return ds;
+        }
+
+        hid_t memoryspace = (ds.needsBoxWrite() ? -1 : ds.plan.memoryspace(stride));
+
+        if (memoryspace < 0) {
+            blitz::Array<T,N> contiguous(A.shape());
+            contiguous = A;
+            return ds << contiguous.data();
+        }
+
+        ds.write(Dtype(NativeDtype<T>::name()), memoryspace, ds.plan.filespace(), A.data());
+        H5Sclose(memoryspace);
+        return ds;
+    }
 }
 
 
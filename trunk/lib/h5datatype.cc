@@ -50,6 +50,8 @@ namespace h5 {
     std::map<std::string, hid_t> Dtype::dtype_;
     hid_t Dtype::compound_type_native_complex_float_;
     hid_t Dtype::compound_type_native_complex_double_;
+    hid_t Dtype::float16_;
+    hid_t Dtype::bfloat16_;
 
     Dtype::Dtype(std::string dtype_str) {
         this->selected_dtype_str_ = dtype_str;
@@ -58,6 +60,8 @@ namespace h5 {
     void Dtype::finalize() {
         H5Tclose(compound_type_native_complex_float_);
         H5Tclose(compound_type_native_complex_double_);
+        H5Tclose(float16_);
+        H5Tclose(bfloat16_);
     }
 
     void Dtype::init() {
@@ -71,6 +75,22 @@ namespace h5 {
         H5Tinsert(compound_type_native_complex_double_, "imag", H5Tget_size(H5T_NATIVE_DOUBLE), H5T_NATIVE_DOUBLE);
         // H5Tlock(compound_type_native_complex_double_);
 
+        // 16 bit floats, little endian: IEEE half precision and bfloat16 (the upper half of a float)
+        float16_ = H5Tcopy(H5T_IEEE_F32LE);
+        H5Tset_fields(float16_, 15, 10, 5, 0, 10);
+        H5Tset_precision(float16_, 16);
+        H5Tset_size(float16_, 2);
+        H5Tset_ebias(float16_, 15);
+
+        bfloat16_ = H5Tcopy(H5T_IEEE_F32LE);
+        H5Tset_fields(bfloat16_, 15, 7, 8, 0, 7);
+        H5Tset_precision(bfloat16_, 16);
+        H5Tset_size(bfloat16_, 2);
+        H5Tset_ebias(bfloat16_, 127);
+
+        dtype_["f16"] = float16_;
+        dtype_["bf16"] = bfloat16_;
+
         dtype_[">f32"] =  H5T_IEEE_F32BE;
         dtype_["<f32"] =  H5T_IEEE_F32LE;
         dtype_[">f64"] =  H5T_IEEE_F64BE;
@@ -43,6 +43,7 @@
 
 #include <map>
 #include <string>
+#include <complex>
 #include <hdf5.h>
 
 
@@ -69,6 +70,8 @@ namespace h5 {
 
         static hid_t compound_type_native_complex_float_;
         static hid_t compound_type_native_complex_double_;
+        static hid_t float16_;
+        static hid_t bfloat16_;
 
         static unsigned int reference_count_;    /**<  Keeps a count of number of instances of this class.
                                                        Last instance closes compound types. */
@@ -84,6 +87,28 @@ namespace h5 {
 
         operator hid_t() const { return this->dtype_[this->selected_dtype_str_]; }
     };
+
+    /**
+     * Name of the native datatype corresponding to a C++ type, e.g. Dtype(NativeDtype<double>::name())
+     */
+    template<typename T> struct NativeDtype;
+
+    template<> struct NativeDtype<char> { static const char *name() { return "char"; } };
+    template<> struct NativeDtype<signed char> { static const char *name() { return "schar"; } };
+    template<> struct NativeDtype<unsigned char> { static const char *name() { return "uchar"; } };
+    template<> struct NativeDtype<short> { static const char *name() { return "short"; } };
+    template<> struct NativeDtype<unsigned short> { static const char *name() { return "ushort"; } };
+    template<> struct NativeDtype<int> { static const char *name() { return "int"; } };
+    template<> struct NativeDtype<unsigned int> { static const char *name() { return "uint"; } };
+    template<> struct NativeDtype<long> { static const char *name() { return "long"; } };
+    template<> struct NativeDtype<unsigned long> { static const char *name() { return "ulong"; } };
+    template<> struct NativeDtype<long long> { static const char *name() { return "llong"; } };
+    template<> struct NativeDtype<unsigned long long> { static const char *name() { return "ullong"; } };
+    template<> struct NativeDtype<float> { static const char *name() { return "float"; } };
+    template<> struct NativeDtype<double> { static const char *name() { return "double"; } };
+    template<> struct NativeDtype<long double> { static const char *name() { return "ldouble"; } };
+    template<> struct NativeDtype<std::complex<float> > { static const char *name() { return "cfloat"; } };
+    template<> struct NativeDtype<std::complex<double> > { static const char *name() { return "cdouble"; } };
 }
 
 #endif
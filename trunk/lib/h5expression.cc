@@ -43,37 +43,28 @@
 
 #include "h5expression.h"
 
+#include <cctype>
+
 namespace h5 {
 
+    //Parse selects one after the other, e.g. "[0:10, :] - [5, 2:3]", without copying the string
     Expression::Expression(std::string expression_str) {
-        std::string select_str;
-
-        size_t current_op_index=0;
-        size_t next_op_index=0;
-
-        expression_str.erase(std::remove(expression_str.begin(), expression_str.end(), ' '), expression_str.end());
-        if (expression_str.length()<=0)
-            return;
+        const char *p = expression_str.c_str();
 
-        if (expression_str.find_first_of("+-")!=0)
-            expression_str = "+" + expression_str;
+        for (;;) {
+            while (isspace(*p))
+                p++;
 
-        current_op_index = expression_str.find_first_of("+-", 0);
+            if (*p == '\0')
+                break;
 
-        //extract each range with their signs.
-        while (next_op_index != std::string::npos) {
-            next_op_index = expression_str.find_first_of("+-", current_op_index+1);
-
-            if (next_op_index!=std::string::npos) {
-                select_str = expression_str.substr(current_op_index, next_op_index-current_op_index);
-            }
-            else {
-                select_str = expression_str.substr(current_op_index);
+            Select select;
+            if (!Select::Parse(p, select)) {
+                std::cerr << "Invalid Expression: '" << expression_str << "'" << std::endl;
+                return;
             }
 
-            current_op_index = next_op_index;
-
-            this->expression.push_back(Select(select_str));
+            this->expression.push_back(select);
         }
     }
 
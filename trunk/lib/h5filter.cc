@@ -0,0 +1,544 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5filter.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5filter.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace h5 {
+
+    const H5Z_filter_t Filter::ERROR_BOUNDED;
+    const H5Z_filter_t Filter::SHUFFLE;
+
+    //Client data of ERROR_BOUNDED: mode (0 absolute, 1 relative), the bound as the two halves of a
+    //double, then added by Set_local_error_bounded_: element size and the three folded chunk dimensions
+    enum { EB_MODE, EB_BOUND_LOW, EB_BOUND_HIGH, EB_SIZE, EB_DIM0, EB_DIM1, EB_DIM2, EB_NELMTS };
+
+    struct Error_bounded_header_ {
+        uint32_t size;              // Bytes per element, 4 or 8
+        uint32_t reserved;
+        double bound;               // Absolute error bound used for this chunk
+        uint64_t num_raw;           // Values stored as they are, after the varints
+        uint64_t num_varint_bytes;
+    };
+
+    static htri_t Can_apply_error_bounded_(hid_t dcpl, hid_t dtype, hid_t space) {
+        return (H5Tget_class(dtype) == H5T_FLOAT && (H5Tget_size(dtype) == 4 || H5Tget_size(dtype) == 8)
+                && H5Tget_order(dtype) == H5Tget_order(H5T_NATIVE_DOUBLE));
+    }
+
+    static herr_t Set_local_error_bounded_(hid_t dcpl, hid_t dtype, hid_t space) {
+        unsigned int flags;
+        size_t nelmts = EB_NELMTS;
+        unsigned int values[EB_NELMTS] = {0};
+
+        if (H5Pget_filter_by_id2(dcpl, Filter::ERROR_BOUNDED, &flags, &nelmts, values, 0, NULL, NULL) < 0)
+            return -1;
+
+        int rank = H5Pget_chunk(dcpl, 0, NULL);
+        std::vector<hsize_t> chunk(rank);
+        H5Pget_chunk(dcpl, rank, chunk.data());
+
+        //Fold to three dimensions
+        hsize_t dims[3] = {1, 1, 1};
+        for (int d=0; d<rank; d++)
+            dims[std::max(0, 3 - rank + d)] *= chunk[d];
+
+        values[EB_SIZE] = H5Tget_size(dtype);
+        values[EB_DIM0] = dims[0];
+        values[EB_DIM1] = dims[1];
+        values[EB_DIM2] = dims[2];
+
+        return H5Pmodify_filter(dcpl, Filter::ERROR_BOUNDED, flags, EB_NELMTS, values);
+    }
+
+    static inline void Put_varint_(unsigned char *&out, uint64_t value) {
+        while (value >= 0x80) {
+            *out++ = (unsigned char)(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = (unsigned char)value;
+    }
+
+    static inline size_t Varint_size_(uint64_t value) {
+        size_t size = 1;
+        for (; value >= 0x80; value >>= 7)
+            size++;
+        return size;
+    }
+
+    //Varint at in, before end, false if it runs past end or over 64 bits
+    static inline bool Get_varint_(const unsigned char *&in, const unsigned char *end, uint64_t &value) {
+        value = 0;
+        for (int shift=0; shift<64 && in<end; shift+=7) {
+            unsigned char byte = *in++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (byte < 0x80)
+                return true;
+        }
+        return false;
+    }
+
+    //Lorenzo prediction of point (i,j,k) from decoded points, neighbours outside the chunk count as 0
+    template<typename T>
+    static inline double Predict_(const T *r, size_t i, size_t j, size_t k, size_t n1, size_t n2) {
+        size_t p = (i*n1 + j)*n2 + k;
+        size_t si = n1*n2, sj = n2;
+
+        double a = (k ? r[p-1] : 0);
+        double b = (j ? r[p-sj] : 0);
+        double c = (i ? r[p-si] : 0);
+        double ab = (j && k ? r[p-sj-1] : 0);
+        double ac = (i && k ? r[p-si-1] : 0);
+        double bc = (i && j ? r[p-si-sj] : 0);
+        double abc = (i && j && k ? r[p-si-sj-1] : 0);
+
+        return a + b + c - ab - ac - bc + abc;
+    }
+
+    template<typename T>
+    static size_t Encode_(const T *data, const unsigned int *values, double bound, size_t n, unsigned char *out) {
+        size_t n0 = values[EB_DIM0], n1 = values[EB_DIM1], n2 = values[EB_DIM2];
+
+        Error_bounded_header_ header;
+        header.size = sizeof(T);
+        header.reserved = 0;
+        header.bound = bound;
+        header.num_raw = 0;
+
+        std::vector<T> decoded(n);
+        std::vector<T> raw;
+
+        unsigned char *varints = out + sizeof(header);
+        unsigned char *end = varints;
+
+        const double step = 2*bound;
+        const double max_quantum = 1e15;
+
+        size_t p = 0;
+        for (size_t i=0; i<n0; i++)
+            for (size_t j=0; j<n1; j++)
+                for (size_t k=0; k<n2; k++, p++) {
+                    double prediction = Predict_(&decoded[0], i, j, k, n1, n2);
+                    double quantum = (step > 0 ? floor((data[p] - prediction)/step + 0.5) : 0);
+
+                    T value = T(prediction + step*quantum);
+
+                    //NaNs and infinities fail the comparisons and are stored as they are, so are
+                    //quanta whose varint is longer than the value, which bounds the output by n*(size+1)
+                    int64_t q = (fabs(quantum) < max_quantum ? int64_t(quantum) : 0);
+                    uint64_t symbol = ((uint64_t(q) << 1) ^ uint64_t(q >> 63)) + 1;
+
+                    if (fabs(quantum) < max_quantum && fabs(double(value) - double(data[p])) <= bound && Varint_size_(symbol) <= sizeof(T)) {
+                        Put_varint_(end, symbol);
+                        decoded[p] = value;
+                    }
+                    else {
+                        Put_varint_(end, 0);
+                        raw.push_back(data[p]);
+                        decoded[p] = data[p];
+                    }
+                }
+
+        header.num_raw = raw.size();
+        header.num_varint_bytes = end - varints;
+
+        memcpy(out, &header, sizeof(header));
+        if (!raw.empty())
+            memcpy(end, &raw[0], raw.size()*sizeof(T));
+
+        return sizeof(header) + header.num_varint_bytes + raw.size()*sizeof(T);
+    }
+
+    //Decode the nbytes at in, false if they are not a valid encoding of the chunk
+    template<typename T>
+    static bool Decode_(const unsigned char *in, size_t nbytes, const unsigned int *values, T *data) {
+        size_t n0 = values[EB_DIM0], n1 = values[EB_DIM1], n2 = values[EB_DIM2];
+
+        Error_bounded_header_ header;
+        if (nbytes < sizeof(header))
+            return false;
+        memcpy(&header, in, sizeof(header));
+
+        size_t available = nbytes - sizeof(header);
+        if (header.size != sizeof(T) || header.num_varint_bytes > available || header.num_raw > (available - header.num_varint_bytes)/sizeof(T))
+            return false;
+
+        const unsigned char *varints = in + sizeof(header);
+        const unsigned char *varints_end = varints + header.num_varint_bytes;
+        const unsigned char *raw = varints_end;
+        uint64_t num_raw = 0;
+        const double step = 2*header.bound;
+
+        size_t p = 0;
+        for (size_t i=0; i<n0; i++)
+            for (size_t j=0; j<n1; j++)
+                for (size_t k=0; k<n2; k++, p++) {
+                    uint64_t symbol;
+                    if (!Get_varint_(varints, varints_end, symbol))
+                        return false;
+
+                    if (symbol == 0) {
+                        if (num_raw++ == header.num_raw)
+                            return false;
+
+                        memcpy(&data[p], raw, sizeof(T));
+                        raw += sizeof(T);
+                    }
+                    else {
+                        uint64_t u = symbol - 1;
+                        int64_t q = int64_t(u >> 1) ^ -int64_t(u & 1);
+                        data[p] = T(Predict_(data, i, j, k, n1, n2) + step*double(q));
+                    }
+                }
+
+        return true;
+    }
+
+    template<typename T>
+    static double Bound_(const T *data, size_t n, int mode, double bound) {
+        if (mode == 0)
+            return bound;
+
+        //Relative to the range of the finite values of the chunk
+        double min = INFINITY, max = -INFINITY;
+        for (size_t p=0; p<n; p++) {
+            if (std::isfinite(double(data[p]))) {
+                min = std::min(min, double(data[p]));
+                max = std::max(max, double(data[p]));
+            }
+        }
+
+        return (max > min ? bound*(max - min) : 0);
+    }
+
+    static size_t Error_bounded_filter_(unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[], size_t nbytes, size_t *buf_size, void **buf) {
+        if (cd_nelmts < EB_NELMTS)
+            return 0;
+
+        size_t size = cd_values[EB_SIZE];
+        size_t n = size_t(cd_values[EB_DIM0])*cd_values[EB_DIM1]*cd_values[EB_DIM2];
+
+        if (size != 4 && size != 8)
+            return 0;
+
+        if (flags & H5Z_FLAG_REVERSE) {
+            void *out = H5allocate_memory(n*size, false);
+            if (out == NULL)
+                return 0;
+
+            bool is_valid;
+            if (size == 4)
+                is_valid = Decode_(static_cast<const unsigned char*>(*buf), nbytes, cd_values, static_cast<float*>(out));
+            else
+                is_valid = Decode_(static_cast<const unsigned char*>(*buf), nbytes, cd_values, static_cast<double*>(out));
+
+            if (!is_valid) {
+                H5free_memory(out);
+                return 0;
+            }
+
+            H5free_memory(*buf);
+            *buf = out;
+            *buf_size = n*size;
+            return n*size;
+        }
+
+        if (nbytes != n*size)
+            return 0;
+
+        double bound;
+        uint32_t bound_halves[2] = {cd_values[EB_BOUND_LOW], cd_values[EB_BOUND_HIGH]};
+        memcpy(&bound, bound_halves, sizeof(bound));
+
+        //Worst case: every value a one byte escape plus the raw value, varints are never longer
+        size_t capacity = sizeof(Error_bounded_header_) + n*(size + 1);
+        void *out = H5allocate_memory(capacity, false);
+        if (out == NULL)
+            return 0;
+
+        size_t out_size;
+        if (size == 4) {
+            const float *data = static_cast<const float*>(*buf);
+            out_size = Encode_(data, cd_values, Bound_(data, n, cd_values[EB_MODE], bound), n, static_cast<unsigned char*>(out));
+        }
+        else {
+            const double *data = static_cast<const double*>(*buf);
+            out_size = Encode_(data, cd_values, Bound_(data, n, cd_values[EB_MODE], bound), n, static_cast<unsigned char*>(out));
+        }
+
+        H5free_memory(*buf);
+        *buf = out;
+        *buf_size = capacity;
+        return out_size;
+    }
+
+#ifdef __SSE2__
+    //Perfect shuffle of r registers, the first half interleaved byte by byte with the second.
+    //Applied k times it rotates the byte addresses of the 16*r bytes left by k bits.
+    static inline void Perfect_shuffle_(__m128i *x, __m128i *y, int r) {
+        for (int i=0; i<r/2; i++) {
+            y[2*i] = _mm_unpacklo_epi8(x[i], x[i + r/2]);
+            y[2*i+1] = _mm_unpackhi_epi8(x[i], x[i + r/2]);
+        }
+    }
+#endif
+
+    //Byte shuffle of n elements of 'size' bytes: byte b of element e goes to b*n + e
+    void Filter::shuffle(const unsigned char *src, unsigned char *dst, size_t size, size_t n) {
+        size_t e = 0;
+
+#ifdef __SSE2__
+        //16 elements of 2, 4, 8 or 16 bytes are 16*size bytes with addresses element*size + byte,
+        //four perfect shuffles rotate them to byte*16 + element
+        if (size == 2 || size == 4 || size == 8 || size == 16) {
+            int r = size;
+            __m128i x[16], y[16];
+
+            for (; e+16<=n; e+=16) {
+                for (int k=0; k<r; k++)
+                    x[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + e*size) + k);
+
+                Perfect_shuffle_(x, y, r);
+                Perfect_shuffle_(y, x, r);
+                Perfect_shuffle_(x, y, r);
+                Perfect_shuffle_(y, x, r);
+
+                for (int k=0; k<r; k++)
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k*n + e), x[k]);
+            }
+        }
+#endif
+
+        for (; e<n; e++)
+            for (size_t b=0; b<size; b++)
+                dst[b*n + e] = src[e*size + b];
+    }
+
+    void Filter::unshuffle(const unsigned char *src, unsigned char *dst, size_t size, size_t n) {
+        size_t e = 0;
+
+#ifdef __SSE2__
+        //Inverse rotation, log2(16*size) - 4 perfect shuffles
+        if (size == 2 || size == 4 || size == 8 || size == 16) {
+            int r = size;
+            int passes = (size == 2 ? 1 : size == 4 ? 2 : size == 8 ? 3 : 4);
+            __m128i x[16], y[16];
+
+            for (; e+16<=n; e+=16) {
+                for (int k=0; k<r; k++)
+                    x[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k*n + e));
+
+                for (int p=0; p<passes; p++) {
+                    Perfect_shuffle_(x, y, r);
+                    for (int k=0; k<r; k++)
+                        x[k] = y[k];
+                }
+
+                for (int k=0; k<r; k++)
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + e*size) + k, x[k]);
+            }
+        }
+#endif
+
+        for (; e<n; e++)
+            for (size_t b=0; b<size; b++)
+                dst[e*size + b] = src[b*n + e];
+    }
+
+    //Transpose of the 8x8 bit matrix whose rows are the bytes of x
+    static inline uint64_t Transpose_bits_(uint64_t x) {
+        uint64_t t;
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+        x = x ^ t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+        x = x ^ t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+        x = x ^ t ^ (t << 28);
+        return x;
+    }
+
+    //Split each of the 'streams' byte streams of n bytes, n a multiple of 8, into 8 bit planes
+    static void Bit_transpose_(const unsigned char *src, unsigned char *dst, size_t streams, size_t n) {
+        size_t plane = n/8;
+
+        for (size_t s=0; s<streams; s++) {
+            const unsigned char *in = src + s*n;
+            unsigned char *out = dst + s*n;
+
+            for (size_t g=0; g<plane; g++) {
+                uint64_t x;
+                memcpy(&x, in + 8*g, 8);
+                x = Transpose_bits_(x);
+
+                for (int k=0; k<8; k++)
+                    out[k*plane + g] = (unsigned char)(x >> (8*k));
+            }
+        }
+    }
+
+    static void Bit_untranspose_(const unsigned char *src, unsigned char *dst, size_t streams, size_t n) {
+        size_t plane = n/8;
+
+        for (size_t s=0; s<streams; s++) {
+            const unsigned char *in = src + s*n;
+            unsigned char *out = dst + s*n;
+
+            for (size_t g=0; g<plane; g++) {
+                uint64_t x = 0;
+                for (int k=0; k<8; k++)
+                    x |= uint64_t(in[k*plane + g]) << (8*k);
+
+                x = Transpose_bits_(x);
+                memcpy(out + 8*g, &x, 8);
+            }
+        }
+    }
+
+    //Client data of SHUFFLE: mode (0 byte, 1 bit), then added by Set_local_shuffle_: element size
+    enum { SH_MODE, SH_SIZE, SH_NELMTS };
+
+    static herr_t Set_local_shuffle_(hid_t dcpl, hid_t dtype, hid_t space) {
+        unsigned int flags;
+        size_t nelmts = SH_NELMTS;
+        unsigned int values[SH_NELMTS] = {0};
+
+        if (H5Pget_filter_by_id2(dcpl, Filter::SHUFFLE, &flags, &nelmts, values, 0, NULL, NULL) < 0)
+            return -1;
+
+        values[SH_SIZE] = H5Tget_size(dtype);
+        return H5Pmodify_filter(dcpl, Filter::SHUFFLE, flags, SH_NELMTS, values);
+    }
+
+    //Byte mode keeps the layout of HDF5's shuffle, whole elements shuffled and trailing bytes at the
+    //end. Bit mode shuffles groups of 8 elements and splits each byte stream into bit planes.
+    static size_t Shuffle_filter_(unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[], size_t nbytes, size_t *buf_size, void **buf) {
+        if (cd_nelmts < SH_NELMTS || cd_values[SH_SIZE] == 0)
+            return 0;
+
+        bool bits = (cd_values[SH_MODE] == 1);
+        size_t size = cd_values[SH_SIZE];
+        size_t n = (bits ? (nbytes/size) & ~size_t(7) : (size > 1 ? nbytes/size : 0));
+
+        if (n <= 1)
+            return nbytes;
+
+        unsigned char *out = static_cast<unsigned char*>(H5allocate_memory(nbytes, false));
+        unsigned char *tmp = (bits ? static_cast<unsigned char*>(H5allocate_memory(n*size, false)) : NULL);
+        if (out == NULL || (bits && tmp == NULL)) {
+            H5free_memory(out);
+            H5free_memory(tmp);
+            return 0;
+        }
+
+        const unsigned char *in = static_cast<const unsigned char*>(*buf);
+
+        if (flags & H5Z_FLAG_REVERSE) {
+            if (bits) {
+                Bit_untranspose_(in, tmp, size, n);
+                Filter::unshuffle(tmp, out, size, n);
+            }
+            else
+                Filter::unshuffle(in, out, size, n);
+        }
+        else {
+            if (bits) {
+                Filter::shuffle(in, tmp, size, n);
+                Bit_transpose_(tmp, out, size, n);
+            }
+            else
+                Filter::shuffle(in, out, size, n);
+        }
+
+        memcpy(out + n*size, in + n*size, nbytes - n*size);
+
+        H5free_memory(tmp);
+        H5free_memory(*buf);
+        *buf = out;
+        *buf_size = nbytes;
+        return nbytes;
+    }
+
+    static const H5Z_class2_t Error_bounded_class_ = {
+        H5Z_CLASS_T_VERS,
+        Filter::ERROR_BOUNDED,
+        1, 1,
+        "h5si error bounded",
+        Can_apply_error_bounded_,
+        Set_local_error_bounded_,
+        Error_bounded_filter_
+    };
+
+    static const H5Z_class2_t Shuffle_class_ = {
+        H5Z_CLASS_T_VERS,
+        Filter::SHUFFLE,
+        1, 1,
+        "h5si shuffle",
+        NULL,
+        Set_local_shuffle_,
+        Shuffle_filter_
+    };
+
+    const H5Z_class2_t *Filter::error_bounded_class() {
+        return &Error_bounded_class_;
+    }
+
+    const H5Z_class2_t *Filter::shuffle_class() {
+        return &Shuffle_class_;
+    }
+
+    //Register the filters, called by h5::init()
+    void Filter::init() {
+        H5Zregister(Filter::error_bounded_class());
+        H5Zregister(Filter::shuffle_class());
+    }
+
+}
@@ -0,0 +1,95 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5filter.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5FILTER
+#define _H_H5FILTER
+
+#include <hdf5.h>
+#include <cstddef>
+
+namespace h5 {
+
+    /**
+     * HDF5 filters built into the library and registered with H5Zregister by h5::init(), so
+     * datasets using them need no external plugin. They are selected through DatasetOptions.
+     *
+     * ERROR_BOUNDED: lossy codec for float and double chunks. Each value is predicted from its
+     *                already decoded neighbours (3-D Lorenzo predictor, the chunk's leading
+     *                dimensions folded into the first), the prediction error is quantized in
+     *                steps of twice the error bound and stored as a zigzag varint. Values that
+     *                cannot be reconstructed within the bound are stored as they are. Every
+     *                decoded value is within the bound of the original. The quantized stream
+     *                is meant to be followed by deflate. The bound is absolute, or relative to
+     *                the range of values in each chunk.
+     *
+     * SHUFFLE:       Byte or bit shuffle. Byte mode stores the same layout as HDF5's shuffle,
+     *                byte k of every element together, but transposes 16 elements at a time with
+     *                SSE2 unpack instructions. Bit mode further splits each byte stream into its
+     *                8 bit planes, so that smooth data has long runs of equal bytes for the codec
+     *                that follows. Elements left over after the last group of 8 are kept as is.
+     *
+     * The filter ids are from the range HDF5 leaves for private use, predefined filters such as
+     * H5Z_FILTER_SHUFFLE can not be replaced.
+     *
+     * For programs that do not use H5SI, e.g. h5dump or h5py, the build also makes the plugins
+     * libh5si_shuffle and libh5si_error_bounded, installed in lib/plugin. HDF5 loads them when
+     * HDF5_PLUGIN_PATH names that directory, see h5plugin.cc.
+     */
+    class Filter {
+
+    public:
+        static const H5Z_filter_t ERROR_BOUNDED = 311;
+        static const H5Z_filter_t SHUFFLE = 312;
+
+        static void shuffle(const unsigned char *src, unsigned char *dst, size_t size, size_t n);
+        static void unshuffle(const unsigned char *src, unsigned char *dst, size_t size, size_t n);
+
+        static const H5Z_class2_t *error_bounded_class();
+        static const H5Z_class2_t *shuffle_class();
+
+        static void init();
+    };
+
+}
+
+#endif
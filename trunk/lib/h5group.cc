@@ -92,6 +92,8 @@ namespace h5 {
         }
 
 
+        this->parent_ = parent;
+
         if (this->id_ > 0) {
             this->name_ = this->parent_->name_ + "/" + name;
 
@@ -100,7 +102,6 @@ namespace h5 {
             // this->parent_->register_node(static_cast<Node>(*this));
         }
 
-        this->parent_ = parent;
         this->is_root_ = false;
         this->driver_ = this->parent_->driver_;
 
@@ -96,11 +96,14 @@ namespace h5 {
         Group createGroup(std::string name);
         Group requireGroup(std::string name);
 
-        Dataset create_dataset(std::string name, std::vector<hsize_t> shape, std::string dtype) {
-            return Dataset(this, name, shape, dtype);
+        Dataset create_dataset(std::string name, std::vector<hsize_t> shape, std::string dtype, DatasetOptions options=DatasetOptions()) {
+            return Dataset(this, name, shape, dtype, options);
         }
-        Dataset create_dataset(std::string name, Plan plan, std::string dtype="") {
-            return Dataset(this, name, plan, dtype);
+        Dataset create_dataset(std::string name, Plan plan, std::string dtype="", DatasetOptions options=DatasetOptions()) {
+            return Dataset(this, name, plan, dtype, options);
+        }
+        Dataset create_extendable_dataset(std::string name, std::vector<hsize_t> record_shape, std::string dtype, hsize_t buffer_records=64, DatasetOptions options=DatasetOptions()) {
+            return Dataset(this, name, record_shape, dtype, buffer_records, options);
         }
         // Dataset requireDataset(std::string name);
 
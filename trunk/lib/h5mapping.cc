@@ -0,0 +1,171 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5mapping.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5mapping.h"
+
+#include "h5dataset.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace h5 {
+
+    Mapping::Mapping():address_(NULL), length_(0), reference_count_(NULL), data_(NULL), size_(0), dtype_(-1) { }
+
+    //Map the dataset's raw data, leaves the Mapping invalid if the dataset can not be mapped
+    Mapping::Mapping(const Dataset &ds):address_(NULL), length_(0), reference_count_(NULL), data_(NULL), size_(0), dtype_(-1) {
+
+        if (ds.driver() == "core")
+            return;
+
+        //Contiguous, unfiltered and not external
+        hid_t dcpl = H5Dget_create_plist(ds.id());
+        bool is_mappable = (H5Pget_layout(dcpl) == H5D_CONTIGUOUS && H5Pget_nfilters(dcpl) == 0 && H5Pget_external_count(dcpl) == 0);
+        H5Pclose(dcpl);
+
+        //Stored in native format
+        hid_t native_dtype = H5Tget_native_type(ds.dtype(), H5T_DIR_ASCEND);
+        is_mappable = is_mappable && (H5Tequal(ds.dtype(), native_dtype) > 0);
+        H5Tclose(native_dtype);
+
+        haddr_t offset = H5Dget_offset(ds.id());
+
+        if (!is_mappable || offset == HADDR_UNDEF)
+            return;
+
+        ssize_t filename_length = H5Fget_name(ds.id(), NULL, 0);
+        std::vector<char> filename(filename_length+1);
+        H5Fget_name(ds.id(), filename.data(), filename.size());
+
+        int fd = open(filename.data(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        this->shape_ = ds.shape();
+        this->size_ = H5Tget_size(ds.dtype());
+        for (std::vector<hsize_t>::size_type d=0; d<this->shape_.size(); d++)
+            this->size_ *= this->shape_[d];
+
+        //mmap offsets must be multiples of the page size
+        size_t page_size = sysconf(_SC_PAGESIZE);
+        size_t page_offset = offset % page_size;
+
+        this->length_ = this->size_ + page_offset;
+        this->address_ = mmap(NULL, this->length_, PROT_READ, MAP_SHARED, fd, offset - page_offset);
+        close(fd);
+
+        if (this->address_ == MAP_FAILED) {
+            this->address_ = NULL;
+            this->length_ = 0;
+            this->size_ = 0;
+            this->shape_.clear();
+            return;
+        }
+
+        this->data_ = static_cast<const char*>(this->address_) + page_offset;
+        this->dtype_ = H5Tget_native_type(ds.dtype(), H5T_DIR_ASCEND);
+        this->reference_count_ = new int(1);
+    }
+
+    Mapping::Mapping(const Mapping &mapping):address_(mapping.address_), length_(mapping.length_), reference_count_(mapping.reference_count_), data_(mapping.data_), size_(mapping.size_), dtype_(mapping.dtype_), shape_(mapping.shape_) {
+        if (this->reference_count_)
+            ++*this->reference_count_;
+    }
+
+    Mapping::~Mapping() {
+        this->release();
+    }
+
+    void Mapping::release() {
+        if (this->reference_count_ && --*this->reference_count_ == 0) {
+            munmap(this->address_, this->length_);
+            H5Tclose(this->dtype_);
+            delete this->reference_count_;
+        }
+
+        this->address_ = NULL;
+        this->length_ = 0;
+        this->reference_count_ = NULL;
+        this->data_ = NULL;
+        this->size_ = 0;
+        this->dtype_ = -1;
+    }
+
+    bool Mapping::isValid() const {
+        return (this->data_ != NULL);
+    }
+
+    const void *Mapping::data() const {
+        return this->data_;
+    }
+
+    size_t Mapping::size() const {
+        return this->size_;
+    }
+
+    std::vector<hsize_t> Mapping::shape() const {
+        return this->shape_;
+    }
+
+    Mapping &Mapping::operator=(const Mapping &mapping) {
+        if (this == &mapping)
+            return *this;
+
+        this->release();
+
+        this->address_ = mapping.address_;
+        this->length_ = mapping.length_;
+        this->reference_count_ = mapping.reference_count_;
+        this->data_ = mapping.data_;
+        this->size_ = mapping.size_;
+        this->dtype_ = mapping.dtype_;
+        this->shape_ = mapping.shape_;
+
+        if (this->reference_count_)
+            ++*this->reference_count_;
+
+        return *this;
+    }
+
+}
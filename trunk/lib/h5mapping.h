@@ -0,0 +1,121 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5mapping.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5MAPPING
+#define _H_H5MAPPING
+
+#include <hdf5.h>
+#include <vector>
+#include <iostream>
+#include <blitz/array.h>
+
+#include "h5datatype.h"
+
+namespace h5 {
+
+    class Dataset;
+
+    /**
+     * Read-only memory mapping of a dataset, e.g.
+     *
+     *     h5::Mapping mapping(f["U.V1"]);
+     *     if (mapping.isValid()) {
+     *         blitz::Array<double,3> U = mapping.array<double,3>();
+     *         ...
+     *     }
+     *
+     * The byte range of the dataset in the file is mapped with mmap, so opening is
+     * instantaneous and only the pages that are touched are read. This is possible for
+     * datasets that are contiguous, allocated, unfiltered, stored in native format and not
+     * in external files; otherwise isValid() returns false and the dataset must be read
+     * with operator>>.
+     *
+     * The mapping is unmapped when the last copy of the Mapping is destroyed, arrays returned
+     * by array() must not be used afterwards and must not be written to. Data written through
+     * HDF5 must be flushed before the dataset is mapped.
+     */
+    class Mapping
+    {
+        void *address_;             // Page aligned start of the mapping
+        size_t length_;             // Length of the mapping
+        int *reference_count_;      // Number of Mapping objects sharing this mapping
+
+        const char *data_;          // First element of the dataset
+        size_t size_;               // Size of the dataset in bytes
+        hid_t dtype_;               // Native datatype of the dataset, shared like the mapping
+        std::vector<hsize_t> shape_;
+
+        void release();
+
+    public:
+        Mapping();
+        Mapping(const Dataset &ds);
+        Mapping(const Mapping &mapping);
+        ~Mapping();
+
+        bool isValid() const;
+
+        const void *data() const;
+        size_t size() const;
+        std::vector<hsize_t> shape() const;
+
+        template<typename T, int N>
+        blitz::Array<T,N> array() const {
+            if (!this->isValid() || H5Tequal(Dtype(NativeDtype<T>::name()), this->dtype_) <= 0 || N != int(this->shape_.size())) {
+                std::cerr << "Mapping::array: Element type or rank does not match the mapped dataset" << std::endl;
+                return blitz::Array<T,N>();
+            }
+
+            blitz::TinyVector<int,N> extent;
+            for (int d=0; d<N; d++)
+                extent(d) = this->shape_[d];
+
+            return blitz::Array<T,N>(const_cast<T*>(reinterpret_cast<const T*>(this->data_)), extent, blitz::neverDeleteData);
+        }
+
+        Mapping &operator=(const Mapping &mapping);
+    };
+
+}
+
+#endif
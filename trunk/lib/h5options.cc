@@ -0,0 +1,179 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5options.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5options.h"
+#include "h5filter.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+namespace h5 {
+
+    DatasetOptions::DatasetOptions():alloc_time_("default"), fill_time_("default"), has_fill_value_(false), fill_value_(0), shuffle_(false), deflate_(-1), error_bound_(-1), error_bound_mode_("absolute"), hermitian_(false) { }
+
+    DatasetOptions &DatasetOptions::alloc_time(std::string alloc_time) {
+        if (alloc_time != "default" && alloc_time != "early" && alloc_time != "late" && alloc_time != "incremental") {
+            std::cerr << "DatasetOptions: Invalid allocation time '" << alloc_time << "'" << std::endl;
+            exit(1);
+        }
+
+        this->alloc_time_ = alloc_time;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::fill_time(std::string fill_time) {
+        if (fill_time != "default" && fill_time != "alloc" && fill_time != "never" && fill_time != "ifset") {
+            std::cerr << "DatasetOptions: Invalid fill time '" << fill_time << "'" << std::endl;
+            exit(1);
+        }
+
+        this->fill_time_ = fill_time;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::fill_value(double fill_value) {
+        this->has_fill_value_ = true;
+        this->fill_value_ = fill_value;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::chunk(std::vector<hsize_t> chunk) {
+        this->chunk_ = chunk;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::shuffle(bool shuffle) {
+        this->shuffle_ = shuffle;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::simd_shuffle(std::string mode) {
+        if (mode != "byte" && mode != "bit") {
+            std::cerr << "DatasetOptions: Invalid shuffle mode '" << mode << "', expected byte or bit" << std::endl;
+            exit(1);
+        }
+
+        this->simd_shuffle_ = mode;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::deflate(int level) {
+        if (level < 0 || level > 9) {
+            std::cerr << "DatasetOptions: Invalid deflate level " << level << std::endl;
+            exit(1);
+        }
+
+        this->deflate_ = level;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::error_bound(double bound, std::string mode) {
+        if (bound < 0 || (mode != "absolute" && mode != "relative")) {
+            std::cerr << "DatasetOptions: Invalid error bound " << bound << " " << mode << std::endl;
+            exit(1);
+        }
+
+        this->error_bound_ = bound;
+        this->error_bound_mode_ = mode;
+        return *this;
+    }
+
+    DatasetOptions &DatasetOptions::hermitian(bool hermitian) {
+        this->hermitian_ = hermitian;
+        return *this;
+    }
+
+    bool DatasetOptions::isHermitian() const {
+        return this->hermitian_;
+    }
+
+    //Create a dataset creation property list with these options, the caller must close it
+    hid_t DatasetOptions::create_dcpl() const {
+        hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+
+        if (this->alloc_time_ == "early")
+            H5Pset_alloc_time(dcpl, H5D_ALLOC_TIME_EARLY);
+        else if (this->alloc_time_ == "late")
+            H5Pset_alloc_time(dcpl, H5D_ALLOC_TIME_LATE);
+        else if (this->alloc_time_ == "incremental")
+            H5Pset_alloc_time(dcpl, H5D_ALLOC_TIME_INCR);
+
+        if (this->fill_time_ == "alloc")
+            H5Pset_fill_time(dcpl, H5D_FILL_TIME_ALLOC);
+        else if (this->fill_time_ == "never")
+            H5Pset_fill_time(dcpl, H5D_FILL_TIME_NEVER);
+        else if (this->fill_time_ == "ifset")
+            H5Pset_fill_time(dcpl, H5D_FILL_TIME_IFSET);
+
+        if (this->has_fill_value_)
+            H5Pset_fill_value(dcpl, H5T_NATIVE_DOUBLE, &this->fill_value_);
+
+        if (!this->chunk_.empty())
+            H5Pset_chunk(dcpl, this->chunk_.size(), this->chunk_.data());
+
+        if (this->error_bound_ >= 0) {
+            unsigned int values[3];
+            values[0] = (this->error_bound_mode_ == "relative");
+            memcpy(&values[1], &this->error_bound_, sizeof(double));
+
+            H5Pset_filter(dcpl, Filter::ERROR_BOUNDED, H5Z_FLAG_MANDATORY, 3, values);
+        }
+
+        if (this->shuffle_)
+            H5Pset_shuffle(dcpl);
+
+        if (!this->simd_shuffle_.empty()) {
+            unsigned int mode = (this->simd_shuffle_ == "bit");
+            H5Pset_filter(dcpl, Filter::SHUFFLE, H5Z_FLAG_MANDATORY, 1, &mode);
+        }
+
+        if (this->deflate_ >= 0)
+            H5Pset_deflate(dcpl, this->deflate_);
+        else if (this->error_bound_ >= 0)
+            H5Pset_deflate(dcpl, 1);
+
+        return dcpl;
+    }
+
+}
@@ -0,0 +1,118 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5options.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5OPTIONS
+#define _H_H5OPTIONS
+
+#include <hdf5.h>
+#include <string>
+#include <vector>
+
+namespace h5 {
+
+    /**
+     * Options used when a dataset is created, e.g.
+     *
+     *     h5::DatasetOptions options;
+     *     options.alloc_time("late").fill_time("never");
+     *     f.create_dataset("U.V1", h5::shape(N,N,N), "double", options);
+     *
+     * alloc_time: "default", "early", "late", "incremental"
+     *             When file space is allocated for the raw data.
+     * fill_time:  "default", "alloc", "never", "ifset"
+     *             When the fill value is written to newly allocated space. "never" avoids a pass
+     *             over the whole dataset writing fill values that are overwritten anyway.
+     * fill_value: Value of unwritten elements, converted to the datatype of the dataset.
+     * chunk:      Shape of the chunks, needed by the filters below.
+     * shuffle:    Byte shuffle filter, groups bytes of equal significance before deflate.
+     * simd_shuffle: Filter::SHUFFLE, vectorized "byte" shuffle or "bit" shuffle, in place of the
+     *             shuffle option for data read only through H5SI or with the filter plugin.
+     * deflate:    Deflate (gzip) filter with the given level, 0 to 9.
+     * error_bound: Lossy Filter::ERROR_BOUNDED for float and double data, decoded values are
+     *             within 'bound' of the originals ("absolute"), or within bound times the range
+     *             of values of their chunk ("relative"). Runs before shuffle and deflate,
+     *             deflate level 1 is added if no deflate is set.
+     * hermitian:  Half-spectrum storage of a complex dataset holding the transform of real data.
+     *             Only the first N/2+1 elements of the last dimension of extent N are stored,
+     *             the others are conjugates of stored ones, see Dataset::set_hermitian_reconstruction().
+     *
+     * Parallel HDF5 may force early allocation, fill_time("never") still skips the fill pass.
+     */
+    class DatasetOptions {
+        std::string alloc_time_;
+        std::string fill_time_;
+
+        bool has_fill_value_;
+        double fill_value_;
+
+        std::vector<hsize_t> chunk_;
+        bool shuffle_;
+        std::string simd_shuffle_;  // "byte", "bit", or empty for none
+        int deflate_;           // -1 for no deflate
+
+        double error_bound_;    // < 0 for lossless
+        std::string error_bound_mode_;
+
+        bool hermitian_;
+
+    public:
+        DatasetOptions();
+
+        DatasetOptions &alloc_time(std::string alloc_time);
+        DatasetOptions &fill_time(std::string fill_time);
+        DatasetOptions &fill_value(double fill_value);
+        DatasetOptions &chunk(std::vector<hsize_t> chunk);
+        DatasetOptions &shuffle(bool shuffle=true);
+        DatasetOptions &simd_shuffle(std::string mode="byte");
+        DatasetOptions &deflate(int level=6);
+        DatasetOptions &error_bound(double bound, std::string mode="absolute");
+        DatasetOptions &hermitian(bool hermitian=true);
+
+        bool isHermitian() const;
+
+        hid_t create_dcpl() const;
+    };
+
+}
+
+#endif
@@ -42,6 +42,9 @@
  */
 
 #include "h5plan.h"
+
+#include <algorithm>
+#include "h5region.h"
 #include "vector_ops.h"
 
 namespace h5 {
@@ -67,6 +70,21 @@ namespace h5 {
         return true;
     }
 
+    //Set the indices of range in filter to 1
+    void Plan::Fill_filter_(std::vector<char> &filter, const Range &range) {
+        if (filter.empty() || range.stride() == 0)
+            return;
+
+        hsize_t last = std::min<hsize_t>(range.last(filter.size()-1), filter.size()-1);
+
+        for (hsize_t i=range.first(0); i<=last; i+=range.stride()) {
+            filter[i] = 1;
+
+            if (last - i < range.stride())
+                break;
+        }
+    }
+
     //Get the start index and length of a block in memoryspace_, search starts at 'begin_at'
     //e.g.
     //Filter: 0001100111000
@@ -75,33 +93,25 @@ namespace h5 {
     //Output:
     //start=3
     //blocklength=2
-    void Plan::Get_next_start(blitz::Array<int,1> filter, hsize_t begin_at, int my_id, int numprocs, hsize_t &start, hsize_t &blocklength)
+    void Plan::Get_next_start(const std::vector<char> &filter, hsize_t begin_at, int my_id, int numprocs, hsize_t &start, hsize_t &blocklength)
     {
-        hsize_t end = -1;
-
-        start = begin_at + first(filter(blitz::Range(begin_at, filter.size()))==1);
+        std::vector<char>::const_iterator first = std::find(filter.begin() + std::min<hsize_t>(begin_at, filter.size()), filter.end(), 1);
 
-        if (start>=0 && start<filter.size())
-            end = start + first(filter(blitz::Range(start, filter.size()))==0);
-
-        if (start<0 || start>=filter.size()) {      // start is invalid, i.e. not within local index range
+        if (first == filter.end()) {      // No block after begin_at
             blocklength = 0;
             start = 0;
             return;
         }
 
-        if (end<0 || end>=filter.size()) {      // No zeros were found after start
-            blocklength = filter.size() - start;
-            return;
-        }
-    
-        // start and end both are valid
-        blocklength = end - start;
+        std::vector<char>::const_iterator end = std::find(first, filter.end(), 0);
+
+        start = first - filter.begin();
+        blocklength = end - first;
     }
 
 
 
-    std::vector<Plan::HyperspaceBlock_> Plan::Get_intersections_memoryspace(int rank, int* my_id, int* numprocs, blitz::Array<int,1>* memoryspace_filter) {
+    std::vector<Plan::HyperspaceBlock_> Plan::Get_intersections_memoryspace(int rank, int* my_id, int* numprocs, std::vector<char>* memoryspace_filter) {
 
         std::vector<HyperspaceBlock_> memoryspace_blocks;
         hsize_t start_index, blocklength;
@@ -159,12 +169,12 @@ namespace h5 {
         return memoryspace_blocks;
     }
 
-    std::vector<Plan::HyperspaceBlock_> Plan::Get_intersections_filespace(int nD, int* my_id, int* numprocs, blitz::Array<int,1>* filespace_filter) {
+    std::vector<Plan::HyperspaceBlock_> Plan::Get_intersections_filespace(int nD, int* my_id, int* numprocs, std::vector<char>* filespace_filter) {
 
         std::vector<HyperspaceBlock_> filespace_blocks;
 
         hsize_t start_index, blocklength;
-        int begin_at;
+        hsize_t begin_at;
 
         std::vector<FilterBlock_> filespace_filter_blocks[nD];
 
@@ -219,15 +229,14 @@ namespace h5 {
     //[2,3,4] -> 1st proc has 2 elems in select, 2nd has 3 and 3rd has 4.
     void Plan::Modify_memoryspace(int nD, int *my_id, int *numprocs, hsize_t *memoryspace_dimension, Select select) {
 
-        blitz::Array<int,1> memoryspace_filter[nD];
+        std::vector<char> memoryspace_filter[nD];
         std::vector<HyperspaceBlock_> memoryspace_blocks;
 
         for (int d=0; d<nD; d++) {
-            memoryspace_filter[d].resize(memoryspace_dimension[d]);
-            memoryspace_filter[d]=0;
-            memoryspace_filter[d](select.get_range()[d])=1;
-            memoryspace_filter[d](blitz::Range(0, my_id[d]*memoryspace_dimension[d]/numprocs[d]-1)) = 0;
-            memoryspace_filter[d](blitz::Range((my_id[d]+1)*memoryspace_dimension[d]/numprocs[d], blitz::toEnd)) = 0;
+            memoryspace_filter[d].assign(memoryspace_dimension[d], 0);
+            Fill_filter_(memoryspace_filter[d], select[d]);
+            std::fill(memoryspace_filter[d].begin(), memoryspace_filter[d].begin() + my_id[d]*memoryspace_dimension[d]/numprocs[d], 0);
+            std::fill(memoryspace_filter[d].begin() + (my_id[d]+1)*memoryspace_dimension[d]/numprocs[d], memoryspace_filter[d].end(), 0);
         }
 
 
@@ -289,15 +298,14 @@ namespace h5 {
     //[2,3,4] -> 1st proc has 3 elems, 2nd has 3 and 3rd has 4.
     void Plan::Modify_filespace(int nD, int *my_id, int *numprocs, hsize_t *filespace_dimension, Select select, hsize_t *my_start_index_filespace, hsize_t *my_end_index_filespace) {
 
-        blitz::Array<int,1> filespace_filter[nD];
+        std::vector<char> filespace_filter[nD];
         std::vector<HyperspaceBlock_> filespace_blocks;
 
         for (int d=0; d<nD; d++) {
-            filespace_filter[d].resize(filespace_dimension[d]);
-            filespace_filter[d] = 0;
-            filespace_filter[d](select.get_range()[d]) = 1;
-            filespace_filter[d](blitz::Range(0, my_start_index_filespace[d]-1)) = 0;
-            filespace_filter[d](blitz::Range(my_end_index_filespace[d], blitz::toEnd)) = 0;
+            filespace_filter[d].assign(filespace_dimension[d], 0);
+            Fill_filter_(filespace_filter[d], select[d]);
+            std::fill(filespace_filter[d].begin(), filespace_filter[d].begin() + my_start_index_filespace[d], 0);
+            std::fill(filespace_filter[d].begin() + my_end_index_filespace[d], filespace_filter[d].end(), 0);
         }
 
         filespace_blocks = Get_intersections_filespace(nD, my_id, numprocs, filespace_filter);
@@ -357,8 +365,8 @@ namespace h5 {
 
         hsize_t nD = my_id.size();
 
-        blitz::Array<hsize_t,1> memoryspace_filter[nD];
-        blitz::Array<hsize_t,1> filespace_filter[nD];
+        std::vector<char> memoryspace_filter[nD];
+        std::vector<char> filespace_filter[nD];
 
         hsize_t memoryspace_dimension_hsize[nD];
         hsize_t filespace_dimension_hsize[nD];
@@ -397,22 +405,22 @@ namespace h5 {
         for (Expression::size_type i=0; i<memoryspace_expression.size(); i++) {
             Modify_memoryspace(nD, my_id.data(), numprocs.data(), memoryspace_dimension.data(),  memoryspace_expression[i]);
         }
-        for (hsize_t d=0; d<nD; d++) {
-            memoryspace_filter[d].resize(memoryspace_dimension[d]);
-            memoryspace_filter[d] = 0;
-        }
+        for (hsize_t d=0; d<nD; d++)
+            memoryspace_filter[d].assign(memoryspace_dimension[d], 0);
 
         //Flatten memoryspace_ expression
         for (Expression::size_type i=0; i<memoryspace_expression.size(); i++)
             for (hsize_t d=0; d<nD; d++)
-                memoryspace_filter[d](memoryspace_expression[i][d]) = 1;
+                Fill_filter_(memoryspace_filter[d], memoryspace_expression[i][d]);
 
         //Assume MEMORYSPACE_EQUAL_DIVISION
         //Get start_count and local_count
         for (hsize_t d=0; d<nD; d++) {
-            my_start_count_memoryspace[d] = blitz::sum(memoryspace_filter[d](blitz::Range(0,my_id[d]*memoryspace_dimension[d]/numprocs[d]-1)));
+            std::vector<char>::const_iterator begin = memoryspace_filter[d].begin();
 
-            my_count_memoryspace[d] = blitz::sum(memoryspace_filter[d](blitz::Range(my_id[d]*memoryspace_dimension[d]/numprocs[d], (my_id[d]+1)*memoryspace_dimension[d]/numprocs[d]-1)));
+            my_start_count_memoryspace[d] = std::count(begin, begin + my_id[d]*memoryspace_dimension[d]/numprocs[d], 1);
+
+            my_count_memoryspace[d] = std::count(begin + my_id[d]*memoryspace_dimension[d]/numprocs[d], begin + (my_id[d]+1)*memoryspace_dimension[d]/numprocs[d], 1);
 
         }
 
@@ -422,10 +430,8 @@ namespace h5 {
             this->filespace_ = H5Screate_simple(nD, filespace_dimension_hsize, NULL);
             H5Sselect_none(this->filespace_);
 
-        for (hsize_t d=0; d<nD; d++) {
-            filespace_filter[d].resize(filespace_dimension[d]);
-            filespace_filter[d] = 0;
-        }
+        for (hsize_t d=0; d<nD; d++)
+            filespace_filter[d].assign(filespace_dimension[d], 0);
 
         if (filespace_expression.isEmpty()) {
             filespace_expression = Select::all(nD);
@@ -434,7 +440,7 @@ namespace h5 {
         //Flatten filespace_ expression
         for (Expression::size_type i=0; i<filespace_expression.size(); i++) {
             for (hsize_t d=0; d<nD; d++)
-                filespace_filter[d](filespace_expression[i][d]) = 1;
+                Fill_filter_(filespace_filter[d], filespace_expression[i][d]);
         }
 
         //Get my_start_index and my_end_index
@@ -443,12 +449,12 @@ namespace h5 {
 
             hsize_t my_start_count_filespace = 0;
             for (i=0; i<filespace_dimension[d] && my_start_count_filespace < my_start_count_memoryspace[d]; i++)
-                my_start_count_filespace += filespace_filter[d](i);
+                my_start_count_filespace += filespace_filter[d][i];
             my_start_index_filespace[d] = i;
 
             hsize_t my_count_filespace = 0;
             for (i=my_start_index_filespace[d]; i<filespace_dimension[d] && my_count_filespace<my_count_memoryspace[d]; i++)
-                my_count_filespace += filespace_filter[d](i);
+                my_count_filespace += filespace_filter[d][i];
             my_end_index_filespace[d] = i;
         }
 
@@ -468,6 +474,170 @@ namespace h5 {
         }
     }
 
+    /**
+     * Plan writing the elements of 'region' packed one after the other to a 1-D file space, in
+     * the row major order of the memory space. Each row's runs become hyperslabs of the memory
+     * space directly, without the per-dimension filters of the Select based plans.
+     */
+    void Plan::set_plan(std::vector<hsize_t> memoryspace_dimension, const Region &region, hid_t dtype) {
+        this->my_id_.assign(memoryspace_dimension.size(), 0);
+        this->numprocs_.assign(memoryspace_dimension.size(), 1);
+        this->dtype_ = dtype;
+
+        hsize_t count = this->Select_region_(memoryspace_dimension, region);
+        this->Set_packed_filespace_(0, count, count);
+    }
+
+#ifdef H5SI_ENABLE_MPI
+    //The leading dimension is divided among the processes, which write consecutive parts of the file
+    void Plan::set_plan(MPI_Comm MPI_COMMUNICATOR, std::vector<hsize_t> memoryspace_dimension, const Region &region, hid_t dtype) {
+        this->my_id_.assign(memoryspace_dimension.size(), 0);
+        this->numprocs_.assign(memoryspace_dimension.size(), 1);
+        this->dtype_ = dtype;
+
+        MPI_Comm_rank(MPI_COMMUNICATOR, &this->my_id_[0]);
+        MPI_Comm_size(MPI_COMMUNICATOR, &this->numprocs_[0]);
+
+        unsigned long long count = this->Select_region_(memoryspace_dimension, region);
+        unsigned long long offset = 0, total = 0;
+
+        MPI_Exscan(&count, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMMUNICATOR);
+        MPI_Allreduce(&count, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMMUNICATOR);
+
+        if (this->my_id_[0] == 0)
+            offset = 0;
+
+        this->Set_packed_filespace_(offset, count, total);
+    }
+#endif
+
+    //Select the region's runs in this process's block of the memory space, returns the number of elements
+    hsize_t Plan::Select_region_(std::vector<hsize_t> memoryspace_dimension, const Region &region) {
+        int nD = memoryspace_dimension.size();
+        int last = nD-1;
+
+        this->nD_ = nD;
+        this->memoryspace_dimension_ = memoryspace_dimension;
+        this->memoryspace_expression_ = Expression();
+        this->filespace_expression_ = Expression();
+
+        if (this->numprocs_[last] != 1) {
+            std::cerr << "Plan::set_plan: The last dimension of a region plan can not be divided among processes" << std::endl;
+            exit(1);
+        }
+
+        std::vector<hsize_t> local_dimension(nD), local_start(nD);
+        hsize_t num_rows = 1;
+
+        for (int d=0; d<nD; d++) {
+            local_dimension[d] = memoryspace_dimension[d]/this->numprocs_[d];
+            local_start[d] = this->my_id_[d]*memoryspace_dimension[d]/this->numprocs_[d];
+            if (d < last)
+                num_rows *= local_dimension[d];
+        }
+
+        this->memoryspace_ = H5Screate_simple(nD, local_dimension.data(), NULL);
+        H5Sselect_none(this->memoryspace_);
+
+        std::vector<hsize_t> index(last), local_index(nD, 0);
+        std::vector<hsize_t> start(nD), count(nD, 1);
+        Region::Runs runs;
+        hsize_t num_selected = 0;
+
+        for (hsize_t r=0; r<num_rows && local_dimension[last] > 0; r++) {
+            for (int d=0; d<last; d++)
+                index[d] = local_start[d] + local_index[d];
+
+            runs.clear();
+            region.row_runs(index, memoryspace_dimension, runs);
+
+            for (Region::Runs::size_type i=0; i<runs.size(); i++) {
+                for (int d=0; d<last; d++)
+                    start[d] = local_index[d];
+                start[last] = runs[i].first;
+                count[last] = runs[i].second;
+
+                H5Sselect_hyperslab(this->memoryspace_, H5S_SELECT_OR, start.data(), NULL, count.data(), NULL);
+                num_selected += runs[i].second;
+            }
+
+            //Next row
+            for (int d=last-1; d>=0; d--) {
+                if (++local_index[d] < local_dimension[d])
+                    break;
+                local_index[d] = 0;
+            }
+        }
+
+        return num_selected;
+    }
+
+    //1-D file space of 'total' elements with [offset, offset+count) selected
+    void Plan::Set_packed_filespace_(hsize_t offset, hsize_t count, hsize_t total) {
+        this->filespace_dimension_.assign(1, total);
+        this->filespace_ = H5Screate_simple(1, &total, NULL);
+
+        if (count > 0)
+            H5Sselect_hyperslab(this->filespace_, H5S_SELECT_SET, &offset, NULL, &count, NULL);
+        else
+            H5Sselect_none(this->filespace_);
+    }
+
+    /**
+     * Plan reading or writing the block 'my_id' of the process grid 'numprocs' over an array of
+     * shape 'dimension', the same in memory and file. Unlike the Select based plans the extents
+     * need not divide evenly, the block along d covers [my_id*N/numprocs, (my_id+1)*N/numprocs),
+     * so blocks differ by at most one element and every element is covered.
+     */
+    void Plan::set_block_plan(std::vector<int> my_id, std::vector<int> numprocs, std::vector<hsize_t> dimension, hid_t dtype) {
+        this->set_block_plan(my_id, numprocs, dimension, dimension, dtype);
+    }
+
+    //Block plan whose memory is larger than the file block along dimensions that are not split,
+    //the file block is placed at the start of them, e.g. the full last dimension of a half-spectrum.
+    void Plan::set_block_plan(std::vector<int> my_id, std::vector<int> numprocs, std::vector<hsize_t> memoryspace_dimension, std::vector<hsize_t> filespace_dimension, hid_t dtype) {
+        int nD = filespace_dimension.size();
+
+        std::vector<hsize_t> start(nD), count(nD), memory_count(nD);
+        Select memory_select = Select::all(nD);
+
+        for (int d=0; d<nD; d++) {
+            if (numprocs[d] < 1 || hsize_t(numprocs[d]) > filespace_dimension[d]) {
+                std::cerr << "Plan::set_block_plan: " << numprocs[d] << " processes along dimension " << d << " of extent " << filespace_dimension[d] << std::endl;
+                exit(1);
+            }
+
+            start[d] = my_id[d]*filespace_dimension[d]/numprocs[d];
+            count[d] = (my_id[d]+1)*filespace_dimension[d]/numprocs[d] - start[d];
+            memory_count[d] = count[d];
+
+            if (memoryspace_dimension[d] != filespace_dimension[d]) {
+                if (numprocs[d] != 1 || memoryspace_dimension[d] < filespace_dimension[d]) {
+                    std::cerr << "Plan::set_block_plan: memory extent " << memoryspace_dimension[d] << " along dimension " << d << " does not hold the file extent " << filespace_dimension[d] << " unsplit" << std::endl;
+                    exit(1);
+                }
+
+                memory_count[d] = memoryspace_dimension[d];
+                memory_select[d] = Range(0, filespace_dimension[d]-1);
+            }
+        }
+
+        this->nD_ = nD;
+        this->my_id_ = my_id;
+        this->numprocs_ = numprocs;
+        this->memoryspace_dimension_ = memoryspace_dimension;
+        this->memoryspace_expression_ = memory_select;
+        this->filespace_dimension_ = filespace_dimension;
+        this->filespace_expression_ = Select::all(nD);
+        this->dtype_ = dtype;
+
+        this->memoryspace_ = H5Screate_simple(nD, memory_count.data(), NULL);
+        H5Sselect_hyperslab(this->memoryspace_, H5S_SELECT_SET, std::vector<hsize_t>(nD, 0).data(), NULL, count.data(), NULL);
+
+        this->filespace_ = H5Screate_simple(nD, filespace_dimension.data(), NULL);
+        H5Sselect_hyperslab(this->filespace_, H5S_SELECT_SET, start.data(), NULL, count.data(), NULL);
+    }
+
 /*************
 * Structures and Functions useful for:
 * void Plan::Set_plan(int rank, int* my_id, int* numprocs, Array<int,1>* filespace_filter, Array<int,1>* memoryspace_filter, hid_t datatype)
@@ -674,6 +844,103 @@ void Get_properties_memspace(blitz::Array<int,1> filter, hsize_t begin_at, int m
         return memoryspace_;
     }
 
+    //Memory space of a strided view of the plan's memoryspace, e.g. a slice of a blitz array
+    //stride[d] is the distance in elements between neighbours along dimension d of the view.
+    //Returns a dataspace over the underlying allocation with the plan's memoryspace selection
+    //mapped onto it, or a negative value if the view can not be described this way
+    //(negative or non nested strides, point selections).
+    //The caller must close the returned dataspace.
+    //
+    //With extent e and stride s, offset = sum_d i_d*s_d. Allocation dimensions
+    //  [e_0, s_0/s_1, ..., s_(n-3)/s_(n-2), s_(n-2)]
+    //place i_d at coordinate i_d for d<n-1 and i_(n-1) at i_(n-1)*s_(n-1).
+    hid_t Plan::memoryspace(std::vector<hssize_t> stride) const {
+        int nD = H5Sget_simple_extent_ndims(this->memoryspace_);
+
+        if (nD <= 0 || int(stride.size()) != nD)
+            return -1;
+
+        std::vector<hsize_t> extent(nD);
+        H5Sget_simple_extent_dims(this->memoryspace_, extent.data(), NULL);
+
+        for (int d=0; d<nD; d++) {
+            if (stride[d] <= 0)
+                return -1;
+            if (extent[d] == 0)
+                return H5Scopy(this->memoryspace_);
+        }
+
+        std::vector<hsize_t> dimension(nD);
+
+        if (nD == 1)
+            dimension[0] = (extent[0]-1)*stride[0] + 1;
+        else {
+            dimension[0] = extent[0];
+
+            for (int d=1; d<nD-1; d++) {
+                if (stride[d-1] % stride[d] != 0)
+                    return -1;
+
+                dimension[d] = stride[d-1]/stride[d];
+                if (dimension[d] < extent[d])
+                    return -1;
+            }
+
+            dimension[nD-1] = stride[nD-2];
+            if (dimension[nD-1] < (extent[nD-1]-1)*stride[nD-1] + 1)
+                return -1;
+        }
+
+        //Blocks of the plan's memoryspace selection, as pairs of start and end coordinates
+        std::vector<hsize_t> blocks;
+
+        switch (H5Sget_select_type(this->memoryspace_)) {
+            case H5S_SEL_NONE:
+                break;
+
+            case H5S_SEL_ALL:
+                blocks.resize(2*nD);
+                for (int d=0; d<nD; d++) {
+                    blocks[d] = 0;
+                    blocks[nD+d] = extent[d]-1;
+                }
+                break;
+
+            case H5S_SEL_HYPERSLABS:
+                blocks.resize(2*nD*H5Sget_select_hyper_nblocks(this->memoryspace_));
+                H5Sget_select_hyper_blocklist(this->memoryspace_, 0, blocks.size()/(2*nD), blocks.data());
+                break;
+
+            default:
+                return -1;
+        }
+
+        hid_t memoryspace = H5Screate_simple(nD, dimension.data(), NULL);
+        H5Sselect_none(memoryspace);
+
+        std::vector<hsize_t> start(nD), blockstride(nD), blockcount(nD), blockdim(nD);
+
+        for (std::vector<hsize_t>::size_type b=0; b<blocks.size(); b+=2*nD) {
+            for (int d=0; d<nD; d++) {
+                start[d] = blocks[b+d];
+                blockstride[d] = 1;
+                blockcount[d] = 1;
+                blockdim[d] = blocks[b+nD+d] - blocks[b+d] + 1;
+            }
+
+            if (stride[nD-1] > 1) {
+                start[nD-1] *= stride[nD-1];
+                blockstride[nD-1] = stride[nD-1];
+                blockcount[nD-1] = blockdim[nD-1];
+                blockdim[nD-1] = 1;
+            }
+
+            H5Sselect_hyperslab(memoryspace, H5S_SELECT_OR, start.data(), blockstride.data(), blockcount.data(), blockdim.data());
+        }
+
+        return memoryspace;
+    }
+
     std::vector<int> Plan::my_id() const {
         return this->my_id_;
     }
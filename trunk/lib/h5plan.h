@@ -58,6 +58,8 @@
 
 namespace h5 {
 
+    class Region;
+
     class Plan {
 
         hid_t filespace_;
@@ -93,11 +95,18 @@ namespace h5 {
 
         bool master();
 
-        void Get_next_start(blitz::Array<int,1> filter, hsize_t begin_at, int my_id, int numprocs, hsize_t &start, hsize_t &blocklength);
+        hsize_t Select_region_(std::vector<hsize_t> memoryspace_dimension, const Region &region);
+        void Set_packed_filespace_(hsize_t offset, hsize_t count, hsize_t total);
+
+        //Filters mark the selected indices along one dimension with 1, indexed by hsize_t
+        //unlike blitz arrays, so that extents beyond 2^31 can be selected
+        static void Fill_filter_(std::vector<char> &filter, const Range &range);
+
+        void Get_next_start(const std::vector<char> &filter, hsize_t begin_at, int my_id, int numprocs, hsize_t &start, hsize_t &blocklength);
 
-        std::vector<HyperspaceBlock_> Get_intersections_memoryspace(int nD, int* my_id, int* numprocs, blitz::Array<int,1>* memoryspace_filter);
+        std::vector<HyperspaceBlock_> Get_intersections_memoryspace(int nD, int* my_id, int* numprocs, std::vector<char>* memoryspace_filter);
 
-        std::vector<HyperspaceBlock_> Get_intersections_filespace(int nD, int* my_id, int* numprocs, blitz::Array<int,1>* filespace_filter);
+        std::vector<HyperspaceBlock_> Get_intersections_filespace(int nD, int* my_id, int* numprocs, std::vector<char>* filespace_filter);
 
         void Modify_memoryspace(int nD, int *my_id, int *numprocs, hsize_t *memoryspace_dimension, Select select);
 
@@ -115,7 +124,7 @@ namespace h5 {
 
 
     public:
-        Plan() {}
+        Plan(): filespace_(-1), memoryspace_(-1), nD_(0), dtype_(0) {}
 
         void set_plan(std::vector<hsize_t> memoryspace_dimension, Expression memoryspace_expression, std::vector<hsize_t> filespace_dimension, Expression filespace_expression, hid_t dtype=0);
 
@@ -145,6 +154,17 @@ namespace h5 {
         }
 #endif
 
+        void set_plan(std::vector<hsize_t> memoryspace_dimension, const Region &region, hid_t dtype=0);
+
+#ifdef H5SI_ENABLE_MPI
+        void set_plan(MPI_Comm MPI_COMMUNICATOR, std::vector<hsize_t> memoryspace_dimension, const Region &region, hid_t dtype=0);
+#endif
+
+        void set_block_plan(std::vector<int> my_id, std::vector<int> numprocs, std::vector<hsize_t> dimension, hid_t dtype=0);
+        void set_block_plan(std::vector<int> my_id, std::vector<int> numprocs, std::vector<hsize_t> memoryspace_dimension, std::vector<hsize_t> filespace_dimension, hid_t dtype=0);
+
+        void replace(Plan plan);
+
         void set_plan(int rank, int* my_id, int* numprocs, blitz::Array<int,1>* dataspace_filter, blitz::Array<int,1>* memspace_filter, hid_t dtype);
 
         template<int nD>
@@ -157,6 +177,7 @@ namespace h5 {
 
         hid_t filespace() const;
         hid_t memoryspace() const;
+        hid_t memoryspace(std::vector<hssize_t> stride) const;
 
         std::vector<int> my_id() const;
         std::vector<int> numprocs() const;
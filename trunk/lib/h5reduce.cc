@@ -0,0 +1,177 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5reduce.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5reduce.h"
+
+#include <iostream>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+namespace h5 {
+
+    Moments::Moments() {
+        this->min_ = std::numeric_limits<double>::infinity();
+        this->max_ = -std::numeric_limits<double>::infinity();
+        this->sum_ = 0;
+        this->sum_squares_ = 0;
+        this->count_ = 0;
+    }
+
+    //Four independent lanes so that the loop vectorizes without reassociating floating point sums
+    void Moments::accumulate(const double * __restrict__ data, size_t n) {
+        double min[4], max[4], sum[4], sum_squares[4];
+
+        for (int k=0; k<4; k++) {
+            min[k] = this->min_;
+            max[k] = this->max_;
+            sum[k] = 0;
+            sum_squares[k] = 0;
+        }
+
+        size_t i=0;
+        for (; i+4<=n; i+=4) {
+            for (int k=0; k<4; k++) {
+                double x = data[i+k];
+                min[k] = (x < min[k] ? x : min[k]);
+                max[k] = (x > max[k] ? x : max[k]);
+                sum[k] += x;
+                sum_squares[k] += x*x;
+            }
+        }
+
+        for (; i<n; i++) {
+            double x = data[i];
+            min[0] = (x < min[0] ? x : min[0]);
+            max[0] = (x > max[0] ? x : max[0]);
+            sum[0] += x;
+            sum_squares[0] += x*x;
+        }
+
+        for (int k=0; k<4; k++) {
+            this->min_ = (min[k] < this->min_ ? min[k] : this->min_);
+            this->max_ = (max[k] > this->max_ ? max[k] : this->max_);
+            this->sum_ += sum[k];
+            this->sum_squares_ += sum_squares[k];
+        }
+
+        this->count_ += n;
+    }
+
+#ifdef H5SI_ENABLE_MPI
+    void Moments::combine(MPI_Comm comm) {
+        double sums[3] = {this->sum_, this->sum_squares_, this->count_};
+
+        MPI_Allreduce(MPI_IN_PLACE, &this->min_, 1, MPI_DOUBLE, MPI_MIN, comm);
+        MPI_Allreduce(MPI_IN_PLACE, &this->max_, 1, MPI_DOUBLE, MPI_MAX, comm);
+        MPI_Allreduce(MPI_IN_PLACE, sums, 3, MPI_DOUBLE, MPI_SUM, comm);
+
+        this->sum_ = sums[0];
+        this->sum_squares_ = sums[1];
+        this->count_ = sums[2];
+    }
+#endif
+
+    bool Moments::isOperator(std::string op) {
+        return op == "count" || op == "min" || op == "max" || op == "sum" || op == "mean"
+            || op == "l2" || op == "rms" || op == "energy";
+    }
+
+    double Moments::value(std::string op) const {
+        if (op == "count")  return this->count();
+        if (op == "min")    return this->min();
+        if (op == "max")    return this->max();
+        if (op == "sum")    return this->sum();
+        if (op == "mean")   return this->mean();
+        if (op == "l2")     return this->l2();
+        if (op == "rms")    return this->rms();
+        if (op == "energy") return this->energy();
+
+        std::cerr << "Unknown reduction '" << op << "', expected one of count, min, max, sum, mean, l2, rms, energy" << std::endl;
+        exit(1);
+    }
+
+    double Moments::mean() const {
+        return this->sum_/this->count_;
+    }
+
+    double Moments::l2() const {
+        return std::sqrt(this->sum_squares_);
+    }
+
+    double Moments::rms() const {
+        return std::sqrt(this->sum_squares_/this->count_);
+    }
+
+    double Moments::energy() const {
+        return 0.5*this->sum_squares_/this->count_;
+    }
+
+    Histogram::Histogram(double min, double max, int num_bins) {
+        this->min_ = min;
+        this->max_ = max;
+        this->counts_.assign(std::max(num_bins, 1), 0);
+    }
+
+    void Histogram::accumulate(const double * __restrict__ data, size_t n) {
+        int num_bins = this->counts_.size();
+        double scale = (this->max_ > this->min_ ? num_bins/(this->max_ - this->min_) : 0);
+
+        for (size_t i=0; i<n; i++) {
+            //NaN and infinities belong to no bin
+            if (!std::isfinite(data[i]))
+                continue;
+
+            double bin = (data[i] - this->min_)*scale;
+            int b = (bin < 0 ? 0 : (bin >= num_bins ? num_bins-1 : int(bin)));
+            this->counts_[b]++;
+        }
+    }
+
+#ifdef H5SI_ENABLE_MPI
+    void Histogram::combine(MPI_Comm comm) {
+        MPI_Allreduce(MPI_IN_PLACE, this->counts_.data(), this->counts_.size(), MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    }
+#endif
+
+}
@@ -0,0 +1,136 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5reduce.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5REDUCE
+#define _H_H5REDUCE
+
+#include <hdf5.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifdef H5SI_ENABLE_MPI
+#include <mpi.h>
+#endif
+
+namespace h5 {
+
+    /**
+     * Reduction over the values of a dataset, see Dataset::reduce().
+     *
+     * accumulate() is called once per block of values, converted to double, in the order they are
+     * stored. Under mpio every process accumulates its share of the dataset, then combine() is
+     * called collectively to merge the partial results of all processes.
+     */
+    class Reduction
+    {
+    public:
+        virtual ~Reduction() {}
+
+        virtual void accumulate(const double *data, size_t n) = 0;
+
+#ifdef H5SI_ENABLE_MPI
+        virtual void combine(MPI_Comm comm) = 0;
+#endif
+    };
+
+    /**
+     * The built in reductions: count, min, max, sum, mean, l2 (square root of the sum of squares),
+     * rms and energy (half the mean of the squares).
+     */
+    class Moments : public Reduction
+    {
+        double min_;
+        double max_;
+        double sum_;
+        double sum_squares_;
+        double count_;
+
+    public:
+        Moments();
+
+        void accumulate(const double *data, size_t n);
+
+#ifdef H5SI_ENABLE_MPI
+        void combine(MPI_Comm comm);
+#endif
+
+        static bool isOperator(std::string op);
+        double value(std::string op) const;
+
+        double count() const { return this->count_; }
+        double min() const { return this->min_; }
+        double max() const { return this->max_; }
+        double sum() const { return this->sum_; }
+        double mean() const;
+        double l2() const;
+        double rms() const;
+        double energy() const;
+    };
+
+
+    /**
+     * Counts of values in bins equal divisions of [min, max], values outside the range go to
+     * the first or last bin, NaN and infinities are skipped.
+     */
+    class Histogram : public Reduction
+    {
+        double min_;
+        double max_;
+        std::vector<unsigned long long> counts_;
+
+    public:
+        Histogram(double min, double max, int num_bins);
+
+        void accumulate(const double *data, size_t n);
+
+#ifdef H5SI_ENABLE_MPI
+        void combine(MPI_Comm comm);
+#endif
+
+        const std::vector<unsigned long long> &counts() const { return this->counts_; }
+    };
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5region.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5region.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace h5 {
+
+    //Number of wavenumbers k >= 0 with k*k < bound, exact for large integers
+    static hsize_t Count_below_(double bound) {
+        if (bound <= 0)
+            return 0;
+
+        hsize_t k = hsize_t(std::sqrt(bound));
+        while (k > 0 && double(k)*k >= bound)
+            k--;
+        while (double(k+1)*(k+1) < bound)
+            k++;
+
+        return k+1;
+    }
+
+    Shell::Shell(double kmin, double kmax, bool half) {
+        this->kmin_ = kmin;
+        this->kmax_ = kmax;
+        this->half_ = half;
+    }
+
+    void Shell::row_runs(const std::vector<hsize_t> &index, const std::vector<hsize_t> &shape, Runs &runs) const {
+        int last = shape.size()-1;
+        hsize_t n = shape[last];
+
+        double k_squared = 0;
+        for (int d=0; d<last; d++) {
+            double k = std::min(index[d], shape[d] - index[d]);
+            k_squared += k*k;
+        }
+
+        //|k_last| from lo to hi-1
+        hsize_t lo = Count_below_(this->kmin_*this->kmin_ - k_squared);
+        hsize_t hi = Count_below_(this->kmax_*this->kmax_ - k_squared);
+
+        if (this->half_) {
+            hi = std::min(hi, n);
+            if (lo < hi)
+                runs.push_back(std::make_pair(lo, hi - lo));
+            return;
+        }
+
+        //Wavenumbers 0 .. n/2 at their index, -1 .. -(n-n/2-1) at n-1 downwards
+        hsize_t positive_end = std::min(hi, n/2 + 1);
+        if (lo < positive_end)
+            runs.push_back(std::make_pair(lo, positive_end - lo));
+
+        hsize_t negative_first = std::max(lo, hsize_t(1));
+        hsize_t negative_end = std::min(hi, n - n/2);
+        if (negative_first < negative_end)
+            runs.push_back(std::make_pair(n - negative_end + 1, negative_end - negative_first));
+    }
+
+    Ball::Ball(double kmax, bool half):Shell(0, kmax, half) { }
+
+}
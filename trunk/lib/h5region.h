@@ -0,0 +1,104 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5region.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5REGION
+#define _H_H5REGION
+
+#include <hdf5.h>
+#include <vector>
+#include <utility>
+
+namespace h5 {
+
+    /**
+     * Selection of an N-D array given row by row, a row being all elements that differ only in
+     * the last index. For each row the region appends the runs of selected elements along the
+     * last dimension, which Plan::set_plan() turns directly into the memory selection of a plan
+     * whose file holds the selected elements packed one after the other, e.g. for dealiased
+     * spectral output
+     *
+     *     h5::Plan plan;
+     *     plan.set_plan(MPI_COMM_WORLD, h5::shape(N,N,N), h5::Ball(N/3.0), h5::Dtype("cdouble"));
+     *     h5::Dataset U = f.create_dataset("U.V1", plan);
+     *     U << u.data();
+     *
+     * Derive from Region for other shapes. The plan is read back by setting it on the dataset.
+     */
+    class Region {
+
+    public:
+        typedef std::vector< std::pair<hsize_t, hsize_t> > Runs;     // Start and count along the last dimension
+
+        virtual ~Region() {}
+
+        //Append the runs of the row at 'index', the indices of the leading dimensions of an array
+        //of the given shape, in increasing order and not overlapping
+        virtual void row_runs(const std::vector<hsize_t> &index, const std::vector<hsize_t> &shape, Runs &runs) const = 0;
+    };
+
+    /**
+     * Modes with kmin <= |k| < kmax, k the wavenumbers of an array in FFT order: index i of a
+     * dimension of extent n is wavenumber i up to n/2 and i-n beyond. With 'half' the last
+     * dimension holds only the wavenumbers 0, 1, .. of a half-spectrum, see DatasetOptions::hermitian().
+     */
+    class Shell : public Region {
+        double kmin_;
+        double kmax_;
+        bool half_;
+
+    public:
+        Shell(double kmin, double kmax, bool half=false);
+
+        void row_runs(const std::vector<hsize_t> &index, const std::vector<hsize_t> &shape, Runs &runs) const;
+    };
+
+    //Modes with |k| < kmax, the dealiasing sphere
+    class Ball : public Shell {
+
+    public:
+        Ball(double kmax, bool half=false);
+    };
+
+}
+
+#endif
@@ -43,156 +43,230 @@
 
 #include "h5select.h"
 
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <climits>
+
 namespace h5 {
 
+Range::Range():first_(0), last_(0), stride_(1), from_start_(true), to_end_(true) { }
+
+Range::Range(hsize_t index):first_(index), last_(index), stride_(1), from_start_(false), to_end_(false) { }
+
+Range::Range(hsize_t first, hsize_t last, hsize_t stride):first_(first), last_(last), stride_(stride), from_start_(false), to_end_(false) { }
+
+Range::Range(const blitz::Range &range) {
+    this->from_start_ = (range.first(blitz::fromStart) == blitz::fromStart);
+    this->to_end_ = (range.last(blitz::toEnd) == blitz::toEnd);
+    this->first_ = (this->from_start_ ? 0 : range.first());
+    this->last_ = (this->to_end_ ? 0 : range.last());
+    this->stride_ = range.stride();
+}
+
+Range Range::all(hsize_t stride) {
+    Range range;
+    range.stride_ = stride;
+    return range;
+}
+
+Range Range::from_start(hsize_t last, hsize_t stride) {
+    Range range(0, last, stride);
+    range.from_start_ = true;
+    return range;
+}
+
+Range Range::to_end(hsize_t first, hsize_t stride) {
+    Range range(first, 0, stride);
+    range.to_end_ = true;
+    return range;
+}
+
+//Equivalent blitz::Range, for code indexing blitz arrays, whose indices are int
+//False, leaving range as it is, when the bounds or stride do not fit an int
+bool Range::to_blitz(blitz::Range &range) const {
+    if ((!this->from_start_ && this->first_ > INT_MAX) || (!this->to_end_ && this->last_ > INT_MAX) || this->stride_ > INT_MAX)
+        return false;
+
+    range = blitz::Range(this->from_start_ ? int(blitz::fromStart) : int(this->first_), this->to_end_ ? int(blitz::toEnd) : int(this->last_), int(this->stride_));
+    return true;
+}
+
+bool Range::operator==(const Range &range) const {
+    return this->from_start_ == range.from_start_ && this->to_end_ == range.to_end_ && this->first(0) == range.first(0)
+        && this->last(0) == range.last(0) && this->stride_ == range.stride_;
+}
+
+static inline void Skip_spaces_(const char *&p) {
+    while (isspace(*p))
+        p++;
+}
+
 //////////////////////////
-//Parse indices and return an equivalent blitz::Range object
+//Parse indices at p, moving p past them
 //e.g.
 //"1"      -> Range(1)         # index 1
 //"0:10"   -> Range(0,10)      # Range 0 to 10, inclusive of both ends
 //"0:10:2" -> Range(0,10,2)    # Range 0 to 10, in steps of 2 inclusive of both ends
+//":", "::" -> Range::all(), "::2" every second index
+//"5:", ":10" -> from 5 to the end, from the start to 10
 ///////////////////////////
-blitz::Range Select::Parse_indices(std::string indices) {
+bool Select::Parse_range_(const char *&p, Range &range) {
+    hsize_t value[3] = {0, 0, 1};
+    bool given[3] = {false, false, false};
+    int part = 0;
 
-    int colon_count = std::count(indices.begin(), indices.end(), ':');
+    for (;;) {
+        Skip_spaces_(p);
 
-    int first_colon_index=indices.find(':');
-    int second_colon_index=indices.find(':', first_colon_index+1);
+        if (isdigit(*p)) {
+            char *end;
+            errno = 0;
+            value[part] = strtoull(p, &end, 10);
+            given[part] = true;
+            p = end;
 
-    blitz::Range range;
+            if (errno == ERANGE)
+                return false;
 
-    if (colon_count==0)
-        range = blitz::Range(atoi(indices.c_str()));
-    else if (colon_count==1) {
-        if (indices == ":")
-            range = blitz::Range(blitz::Range::all());
-        else {
-            int start = atoi(indices.substr(0,first_colon_index).c_str());
-            int stop = atoi(indices.substr(first_colon_index+1).c_str());
-            range = blitz::Range(start, stop);
+            Skip_spaces_(p);
         }
-    }
-    else if (colon_count==2) {
-        if  (indices == "::")
-            range = blitz::Range(blitz::Range::all());
-        else {
-            int start = atoi(indices.substr(0,first_colon_index).c_str());
-            int stop = atoi(indices.substr(first_colon_index+1, second_colon_index - first_colon_index-1).c_str());
-            int step = atoi(indices.substr(second_colon_index+1).c_str());
 
-            range = blitz::Range(start, stop, step);
+        if (*p == ':' && part < 2) {
+            part++;
+            p++;
+            continue;
         }
+
+        break;
     }
 
+    hsize_t stride = (given[2] ? value[2] : 1);
+
+    if (part == 0 && !given[0])
+        return false;
+    if (stride == 0)
+        return false;
+
+    if (part == 0)
+        range = Range(value[0]);
+    else if (!given[0] && !given[1])
+        range = Range::all(stride);
+    else if (!given[0])
+        range = Range::from_start(value[1], stride);
+    else if (!given[1])
+        range = Range::to_end(value[0], stride);
+    else
+        range = Range(value[0], value[1], stride);
+
+    return true;
+}
+
+Range Select::Parse_indices(std::string indices) {
+    const char *p = indices.c_str();
+    Range range;
+
+    if (!Parse_range_(p, range) || *p != '\0')
+        std::cerr << "Invalid indices: '" << indices << "'" << std::endl;
+
     return range;
 }
 
 //////////////////////////
-//Parse ranges and return an equivalent Select object
+//Parse a signed select at p, moving p past its closing bracket
 //e.g.
 // "[0:10:2, 4:20, 5]" -> Select('+',Range(0,10,2),Range(4,20),Range(5))
 // "+[0:10:2, 4:20, 5]" -> Select('+',Range(0,10,2),Range(4,20),Range(5))
 // "-[0:10:2, 4:20, 5]" -> Select('-',Range(0,10,2),Range(4,20),Range(5))
+//The string is not copied, indices are 64-bit.
 //////////////////////////
-Select::Select(std::string select_str) {
+bool Select::Parse(const char *&p, Select &select) {
+    select = Select();
 
-    //remove all spaces
-    select_str.erase(std::remove(select_str.begin(), select_str.end(), ' '), select_str.end());
-    if (select_str.length()<=0)
-        return;
-
-    if (select_str.find_first_of("+-")!=0)
-        select_str = "+" + select_str;
+    Skip_spaces_(p);
+    if (*p == '+' || *p == '-')
+        select.sign_ = *p++;
 
-    this->sign_ = select_str[0];
+    Skip_spaces_(p);
+    if (*p != '[')
+        return false;
+    p++;
 
-    //Check Range is surrounded by a pair of brackets
-    if ( select_str[1]!='[' || select_str[select_str.length()-1]!=']' ) {
-            // if (myid_==0)
-                std::cerr << "Invalid Range: '" << select_str << "'. Each select must be surrounded by a pair of square brackets." << std::endl;
-            // MPI_Abort(MPI_COMM_WORLD, 1);
-    }
+    for (;;) {
+        Range range;
+        if (!Parse_range_(p, range))
+            return false;
 
-    select_str[select_str.length()-1] = ',';
+        select.range_.push_back(range);
 
-    int comma_count = std::count(select_str.begin(), select_str.end(), ',');
-    int nD = comma_count;
-
-    this->range_.reserve(nD);
-
-    size_t comma_index = 1;
-    size_t next_comma_index;
-
-
-    for (int d=0; d<nD; d++) {
-        next_comma_index = select_str.find(",", comma_index+1);
-        this->range_.push_back(Parse_indices(select_str.substr(comma_index+1, next_comma_index - comma_index - 1)));
-        comma_index = next_comma_index;
+        Skip_spaces_(p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        if (*p == ']') {
+            p++;
+            return true;
+        }
+        return false;
     }
+}
 
-/*  //If it has three parts
-    if (std::count(select_str.begin(), select_str.end(), ',')==2) {
-        int index_of_first_comma = select_str.find_first_of(',',1);
-        int index_of_second_comma = select_str.find_first_of(',', index_of_first_comma+1);
-
-        //Range along X-axis
-        std::string range_x_str = select_str.substr(2,index_of_first_comma-2);
-        this->range[0] = Parse_indices(range_x_str);
+Select::Select(std::string select_str) {
+    const char *p = select_str.c_str();
+    this->sign_ = '+';
 
-        //Range along Y-axis
-        std::string range_y_str = select_str.substr(index_of_first_comma+1,index_of_second_comma - index_of_first_comma-1);
-        this->range[1] = Parse_indices(range_y_str);
+    Skip_spaces_(p);
+    if (*p == '\0')
+        return;
 
-        //Range along Z-axis
-        std::string range_z_str = select_str.substr(index_of_second_comma+1, select_str.length()-index_of_second_comma-2);
-        this->range[2] = Parse_indices(range_z_str);
+    bool is_valid = Parse(p, *this);
+    Skip_spaces_(p);
 
-    }
-    else {
-        // if (myid_==0)
-            std::cerr << "Range '" << select_str << "' must have three parts separated by comma." << std::endl;
-        // MPI_Abort(MPI_COMM_WORLD, 1);
-    }*/
+    if (!is_valid || *p != '\0')
+        std::cerr << "Invalid Select: '" << select_str << "', expected comma separated indices first:last:stride in square brackets, e.g. [0:10:2, 4:20, 5]" << std::endl;
 }
 
+//All indices of nD dimensions
 Select Select::all(int nD) {
-    return Select(blitz::Range::all(), blitz::Range::all(), blitz::Range::all());
-}
-
-
-bool isRangeEqual(blitz::Range ra1, blitz::Range ra2) {
-    if ( ( ra1.first(blitz::fromStart) == ra2.first(blitz::fromStart) ) && ( ra1.last(blitz::toEnd) == ra2.last(blitz::toEnd) ) && ( ra1.stride() == ra2.stride() ) )
-        return true;
-
-    return false;
+    Select select;
+    select.range_.assign(nD, Range::all());
+    return select;
 }
 
 
 void Select::Pretty_print(std::string &str, bool print_positive_sign) const {
 
     std::ostringstream oss;
-    blitz::Range all = blitz::Range::all();
     
     if ( (this->sign_ == '+' && print_positive_sign) || (this->sign_ == '-') )
         oss << this->sign_ + std::string(" ");
 
     oss << "[";
 
-    for (std::vector<blitz::Range>::size_type i=0; i<this->range_.size(); i++) {
+    for (std::vector<Range>::size_type i=0; i<this->range_.size(); i++) {
+        const Range &range = this->range_[i];
+
         if(i != 0)
             oss << ",";
 
-        if (isRangeEqual(this->range_[i], all)) {
+        if (range.isAll()) {
             oss << ":";
         }
+        else if (!range.isFromStart() && !range.isToEnd() && range.first() == range.last(0) && range.stride() == 1) {
+            oss << range.first();
+        }
         else {
-            oss << this->range_[i].first(blitz::fromStart);
+            if (!range.isFromStart())
+                oss << range.first();
+
+            oss << ":";
 
-            if (this->range_[i].last() != this->range_[i].first(blitz::fromStart))
-                oss << ":" << this->range_[i].last(blitz::toEnd);
+            if (!range.isToEnd())
+                oss << range.last(0);
 
-            if (this->range_[i].stride() != 1)
-                oss << ":" << this->range_[i].stride();
+            if (range.stride() != 1)
+                oss << ":" << range.stride();
         }
 
     }
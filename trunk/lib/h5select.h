@@ -48,6 +48,7 @@
 #include <algorithm>
 #include <sstream>
 #include <blitz/array.h>
+#include <hdf5.h>
 
 #include <vector>
 
@@ -55,28 +56,73 @@ namespace h5 {
     
 class Expression;
 
+//////////////////////////
+//Indices first, first+stride, .. up to last along one dimension, inclusive of both ends.
+//Bounds and stride are 64-bit, unlike blitz::Range, from which a Range converts implicitly.
+//Range() and Range::all() cover the whole extent, first(lowest) and last(highest) return
+//their argument for an end left open.
+//////////////////////////
+class Range {
+    hsize_t first_;
+    hsize_t last_;
+    hsize_t stride_;
+    bool from_start_;       // first_ is the start of the extent
+    bool to_end_;           // last_ is the end of the extent
+
+    public:
+
+    Range();
+    Range(hsize_t index);
+    Range(hsize_t first, hsize_t last, hsize_t stride=1);
+    Range(const blitz::Range &range);
+
+    static Range all(hsize_t stride=1);
+    static Range from_start(hsize_t last, hsize_t stride=1);
+    static Range to_end(hsize_t first, hsize_t stride=1);
+
+    hsize_t first(hsize_t lowest=0) const { return (this->from_start_ ? lowest : this->first_); }
+    hsize_t last(hsize_t highest) const { return (this->to_end_ ? highest : this->last_); }
+    hsize_t stride() const { return this->stride_; }
+
+    bool isFromStart() const { return this->from_start_; }
+    bool isToEnd() const { return this->to_end_; }
+    bool isAll() const { return this->from_start_ && this->to_end_ && this->stride_ == 1; }
+
+    bool to_blitz(blitz::Range &range) const;
+
+    bool operator==(const Range &range) const;
+};
+
 class Select {
     char sign_;               // '+' or '-'
-    std::vector<blitz::Range> range_;    // range to select along X, Y, and Z respectively
+    std::vector<Range> range_;    // range to select along X, Y, and Z respectively
+
+    static bool Parse_range_(const char *&p, Range &range);
 
     public:
 
-    blitz::Range Parse_indices(std::string indices);
+    static bool Parse(const char *&p, Select &select);
+
+    Range Parse_indices(std::string indices);
 
-    Select(blitz::Range range0) {
+    Select() {
+        this->sign_ = '+';
+    }
+
+    Select(Range range0) {
         this->sign_ = '+';
         this->range_.reserve(1);
         this->range_.push_back(range0);
     }
 
-    Select(blitz::Range range0, blitz::Range range1) {
+    Select(Range range0, Range range1) {
         this->sign_ = '+';
         this->range_.reserve(2);
         this->range_.push_back(range0);
         this->range_.push_back(range1);
     }
 
-    Select(blitz::Range range0, blitz::Range range1, blitz::Range range2) {
+    Select(Range range0, Range range1, Range range2) {
         this->sign_ = '+';
         this->range_.reserve(3);
         this->range_.push_back(range0);
@@ -84,7 +130,7 @@ class Select {
         this->range_.push_back(range2);
     }
 
-    Select(blitz::Range range0, blitz::Range range1, blitz::Range range2, blitz::Range range3) {
+    Select(Range range0, Range range1, Range range2, Range range3) {
         this->sign_ = '+';
         this->range_.reserve(4);
         this->range_.push_back(range0);
@@ -93,7 +139,7 @@ class Select {
         this->range_.push_back(range3);
     }
 
-    Select(blitz::Range range0, blitz::Range range1, blitz::Range range2, blitz::Range range3, blitz::Range range4) {
+    Select(Range range0, Range range1, Range range2, Range range3, Range range4) {
         this->sign_ = '+';
         this->range_.reserve(5);
         this->range_.push_back(range0);
@@ -107,15 +153,17 @@ class Select {
 
     static Select all(int nD);
 
-    std::vector<blitz::Range> get_range() { return range_; }
+    std::vector<Range> get_range() { return range_; }
     char get_sign() { return sign_; }
 
+    size_t size() const { return range_.size(); }
+
     void Negate() {this->sign_ = (this->sign_ == '+' ? '-' : '+');}
 
     void Pretty_print(std::string &str, bool print_positive_sign=false) const;
 
-    blitz::Range operator [](int i) const {return range_[i];}
-    blitz::Range& operator [](int i) {return range_[i];}
+    Range operator [](int i) const {return range_[i];}
+    Range& operator [](int i) {return range_[i];}
 };
 
 }
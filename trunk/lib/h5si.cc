@@ -46,6 +46,7 @@
 namespace h5 {
     void init() {
         Dtype::init();
+        Filter::init();
     }
 
     void finalize() {
@@ -51,10 +51,20 @@
 
 #include "h5shape.h"
 #include "h5datatype.h"
+#include "h5convert.h"
 #include "h5select.h"
 #include "h5expression.h"
+#include "h5region.h"
 #include "h5plan.h"
+#include "h5options.h"
 #include "h5dataset.h"
+#include "h5batch.h"
+#include "h5mapping.h"
+#include "h5slab.h"
+#include "h5reduce.h"
+#include "h5attribute.h"
+#include "h5timeseries.h"
+#include "h5filter.h"
 #include "h5group.h"
 #include "h5node.h"
 #include "h5file.h"
@@ -0,0 +1,314 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5slab.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5slab.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "h5dataset.h"
+#include "h5convert.h"
+
+namespace h5 {
+
+    //Walk the whole dataset
+    SlabIterator::SlabIterator(const Dataset &ds, size_t memory_budget, bool prefetch) {
+        int nD = ds.shape().size();
+
+        this->start_.assign(nD, 0);
+        this->count_ = ds.shape();
+        this->stride_.assign(nD, 1);
+        this->prefetch_ = prefetch;
+
+        this->init(ds, memory_budget);
+    }
+
+    //Walk the box select of the dataset
+    //A Select with a '-' sign, descending or out of bounds ranges are rejected, next() then returns
+    //false and status() is negative.
+    SlabIterator::SlabIterator(const Dataset &ds, Select select, size_t memory_budget, bool prefetch) {
+        std::vector<hsize_t> shape = ds.shape();
+        int nD = shape.size();
+
+        this->start_.assign(nD, 0);
+        this->count_ = shape;
+        this->stride_.assign(nD, 1);
+        this->prefetch_ = prefetch;
+
+        bool is_valid = (select.get_sign() == '+' && int(select.size()) == nD);
+
+        for (int d=0; d<nD && is_valid; d++) {
+            Range range = select[d];
+            hsize_t first = range.first(0);
+            hsize_t last = range.last(shape[d]-1);
+
+            //A negative blitz stride converts to a huge one, with first beyond last
+            if (first > last || last >= shape[d] || range.stride() == 0) {
+                is_valid = false;
+                break;
+            }
+
+            this->start_[d] = first;
+            this->stride_[d] = range.stride();
+            this->count_[d] = (last - first)/range.stride() + 1;
+        }
+
+        if (!is_valid) {
+            std::string select_str;
+            select.Pretty_print(select_str, true);
+            std::cerr << "SlabIterator: " << select_str << " is not an ascending box select within the shape of the dataset" << std::endl;
+
+            this->start_.assign(nD, 0);
+            this->count_ = shape;
+            this->stride_.assign(nD, 1);
+        }
+
+        this->init(ds, memory_budget);
+
+        if (!is_valid)
+            this->status_ = -1;
+    }
+
+    void SlabIterator::init(const Dataset &ds, size_t memory_budget) {
+        this->dataset_ = ds.id();
+        this->native_dtype_ = Convert::native_dtype(ds.dtype());
+        this->dtype_size_ = H5Tget_size(this->native_dtype_);
+        this->nD_ = this->start_.size();
+
+        this->first_slab_ = 0;
+        this->slab_step_ = 1;
+        this->current_ = 0;
+        this->slab_ = 0;
+        this->started_ = false;
+        this->thread_running_ = false;
+        this->prefetch_status_ = 0;
+        this->status_ = 0;
+
+        //The background read calls HDF5 while the caller may call it too
+        hbool_t is_threadsafe = false;
+#if H5_VERSION_GE(1,8,16)
+        if (H5is_library_threadsafe(&is_threadsafe) < 0)
+            is_threadsafe = false;
+#endif
+        if (!is_threadsafe)
+            this->prefetch_ = false;
+
+#ifdef H5SI_ENABLE_MPI
+        if (ds.driver() == "mpio") {
+            int thread_level;
+            MPI_Query_thread(&thread_level);
+            if (thread_level < MPI_THREAD_MULTIPLE)
+                this->prefetch_ = false;
+        }
+#endif
+
+        //Rows of the region that fit in the memory budget
+        size_t row_bytes = this->dtype_size_;
+        for (int d=1; d<this->nD_; d++)
+            row_bytes *= this->count_[d];
+
+        size_t num_buffers = (this->prefetch_ ? 2 : 1);
+
+        this->slab_rows_ = memory_budget/(num_buffers*std::max(row_bytes, size_t(1)));
+
+        //Whole chunks along the leading dimension
+        hid_t dcpl = H5Dget_create_plist(this->dataset_);
+        if (H5Pget_layout(dcpl) == H5D_CHUNKED && this->stride_[0] == 1) {
+            std::vector<hsize_t> chunk(this->nD_);
+            H5Pget_chunk(dcpl, this->nD_, chunk.data());
+
+            if (this->slab_rows_ >= chunk[0])
+                this->slab_rows_ -= this->slab_rows_ % chunk[0];
+        }
+        H5Pclose(dcpl);
+
+        this->slab_rows_ = std::max(std::min(this->slab_rows_, this->count_[0]), hsize_t(1));
+        this->num_slabs_ = (this->count_[0] + this->slab_rows_ - 1)/this->slab_rows_;
+
+        //Dataspaces of a full slab, index 0, and of the last slab, index 1
+        std::vector<hsize_t> count = this->count_;
+        hid_t space = H5Dget_space(this->dataset_);
+
+        for (int i=0; i<2; i++) {
+            count[0] = (i == 0 ? this->slab_rows_ : this->count_[0] - (this->num_slabs_-1)*this->slab_rows_);
+
+            this->filespace_[i] = H5Scopy(space);
+            H5Sselect_hyperslab(this->filespace_[i], H5S_SELECT_SET, this->start_.data(), this->stride_.data(), count.data(), NULL);
+
+            this->memoryspace_[i] = H5Screate_simple(this->nD_, count.data(), NULL);
+        }
+
+        H5Sclose(space);
+
+        this->buffer_[0].resize(this->slab_rows_*row_bytes);
+        if (this->prefetch_)
+            this->buffer_[1].resize(this->slab_rows_*row_bytes);
+    }
+
+    SlabIterator::~SlabIterator() {
+        this->wait();
+
+        for (int i=0; i<2; i++) {
+            H5Sclose(this->filespace_[i]);
+            H5Sclose(this->memoryspace_[i]);
+        }
+
+        H5Tclose(this->native_dtype_);
+    }
+
+    //Walk only slabs my_id, my_id + numprocs, ..., e.g. to share the dataset among MPI processes
+    SlabIterator &SlabIterator::partition(int my_id, int numprocs) {
+        this->first_slab_ = my_id;
+        this->slab_step_ = numprocs;
+        return *this;
+    }
+
+    //Read slab into buffer, the selection of the first slab is shifted to it
+    herr_t SlabIterator::read(hsize_t slab, int buffer) {
+        int i = (slab == this->num_slabs_-1 ? 1 : 0);
+
+        std::vector<hssize_t> offset(this->nD_, 0);
+        offset[0] = slab*this->slab_rows_*this->stride_[0];
+
+        H5Soffset_simple(this->filespace_[i], offset.data());
+
+        return H5Dread(this->dataset_, this->native_dtype_, this->memoryspace_[i], this->filespace_[i], H5P_DEFAULT, this->buffer_[buffer].data());
+    }
+
+    void *SlabIterator::Prefetch_(void *iterator) {
+        SlabIterator *it = static_cast<SlabIterator*>(iterator);
+        it->prefetch_status_ = it->read(it->prefetch_slab_, 1 - it->current_);
+        return NULL;
+    }
+
+    void SlabIterator::wait() {
+        if (this->thread_running_) {
+            pthread_join(this->thread_, NULL);
+            this->thread_running_ = false;
+        }
+    }
+
+    //Move to the next slab, returns false when all slabs have been visited or a read failed
+    //After a failed read the iterator stays stopped and status() is negative.
+    bool SlabIterator::next() {
+        if (this->status_ < 0)
+            return false;
+
+        if (this->thread_running_) {
+            this->wait();
+
+            if (this->prefetch_status_ < 0) {
+                this->status_ = this->prefetch_status_;
+                std::cerr << "SlabIterator: reading slab " << this->prefetch_slab_ << " failed" << std::endl;
+                return false;
+            }
+
+            this->current_ = 1 - this->current_;
+            this->slab_ = this->prefetch_slab_;
+        }
+        else {
+            hsize_t slab = (this->started_ ? this->slab_ + this->slab_step_ : this->first_slab_);
+
+            if (slab >= this->num_slabs_)
+                return false;
+
+            herr_t status = this->read(slab, this->current_);
+
+            if (status < 0) {
+                this->status_ = status;
+                std::cerr << "SlabIterator: reading slab " << slab << " failed" << std::endl;
+                return false;
+            }
+
+            this->slab_ = slab;
+        }
+
+        this->started_ = true;
+
+        //Read the following slab while the caller works on this one
+        if (this->prefetch_ && this->slab_ + this->slab_step_ < this->num_slabs_) {
+            this->prefetch_slab_ = this->slab_ + this->slab_step_;
+
+            if (pthread_create(&this->thread_, NULL, Prefetch_, this) == 0)
+                this->thread_running_ = true;
+        }
+
+        return true;
+    }
+
+    //Negative after a failed read or for a rejected select
+    herr_t SlabIterator::status() const {
+        return this->status_;
+    }
+
+    const void *SlabIterator::data() const {
+        return this->buffer_[this->current_].data();
+    }
+
+    hsize_t SlabIterator::size() const {
+        std::vector<hsize_t> shape = this->shape();
+
+        hsize_t size = 1;
+        for (int d=0; d<this->nD_; d++)
+            size *= shape[d];
+
+        return size;
+    }
+
+    hsize_t SlabIterator::num_slabs() const {
+        return this->num_slabs_;
+    }
+
+    std::vector<hsize_t> SlabIterator::start() const {
+        std::vector<hsize_t> start(this->nD_, 0);
+        start[0] = this->slab_*this->slab_rows_;
+        return start;
+    }
+
+    std::vector<hsize_t> SlabIterator::shape() const {
+        std::vector<hsize_t> shape = this->count_;
+        shape[0] = std::min(this->slab_rows_, this->count_[0] - this->slab_*this->slab_rows_);
+        return shape;
+    }
+
+}
@@ -0,0 +1,141 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5slab.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5SLAB
+#define _H_H5SLAB
+
+#include <hdf5.h>
+#include <vector>
+#include <pthread.h>
+
+#include "h5select.h"
+
+namespace h5 {
+
+    class Dataset;
+
+    /**
+     * Walks a dataset, or a region of it, in slabs along the leading dimension for out-of-core
+     * processing, e.g.
+     *
+     *     h5::SlabIterator slab(f["U.V1"], 512*1024*1024);
+     *     while (slab.next())
+     *         process(slab.data<double>(), slab.start(), slab.shape());
+     *
+     * Slabs hold as many rows as fit in memory_budget bytes (both buffers when prefetching),
+     * rounded down to whole chunks for chunked datasets. The file and memory dataspaces are
+     * built once and moved from slab to slab. Data is read in the native format of the
+     * dataset's datatype, not converted, so data<T>() must be given that type, double in the
+     * example for a dataset stored as double.
+     *
+     * With prefetch the next slab is read on a background thread while the caller processes
+     * the current one. As HDF5 is then called from two threads, prefetching is disabled unless
+     * the library is thread-safe, see H5is_library_threadsafe(), and the caller must not call
+     * HDF5 in the meantime either. Under mpio prefetching also requires MPI_THREAD_MULTIPLE.
+     *
+     * next() also returns false when a read fails, status() then tells it from the end of the walk.
+     */
+    class SlabIterator
+    {
+        hid_t dataset_;
+        hid_t native_dtype_;
+        size_t dtype_size_;
+
+        int nD_;
+        std::vector<hsize_t> start_;        // Region of the dataset walked by the iterator
+        std::vector<hsize_t> count_;
+        std::vector<hsize_t> stride_;
+
+        hsize_t slab_rows_;                 // Rows of the region per slab
+        hsize_t num_slabs_;
+        hsize_t first_slab_;                // This process walks slabs first_slab_, first_slab_ + slab_step_, ...
+        hsize_t slab_step_;
+
+        hid_t filespace_[2];                // Selections of the first full slab and of the last slab
+        hid_t memoryspace_[2];
+
+        std::vector<char> buffer_[2];
+        int current_;                       // Index of the buffer holding the current slab
+        hsize_t slab_;                      // Current slab
+        bool started_;
+
+        bool prefetch_;
+        bool thread_running_;
+        pthread_t thread_;
+        hsize_t prefetch_slab_;
+        herr_t prefetch_status_;
+        herr_t status_;                     // Negative once a read failed, iteration stops
+
+        void init(const Dataset &ds, size_t memory_budget);
+        herr_t read(hsize_t slab, int buffer);
+        void wait();
+
+        static void *Prefetch_(void *iterator);
+
+        SlabIterator(const SlabIterator &iterator);
+        SlabIterator &operator=(const SlabIterator &iterator);
+
+    public:
+        SlabIterator(const Dataset &ds, size_t memory_budget, bool prefetch=true);
+        SlabIterator(const Dataset &ds, Select select, size_t memory_budget, bool prefetch=true);
+        ~SlabIterator();
+
+        SlabIterator &partition(int my_id, int numprocs);
+
+        bool next();
+        herr_t status() const;
+
+        const void *data() const;
+
+        template<typename T>
+        const T *data() const { return reinterpret_cast<const T*>(this->data()); }
+
+        hsize_t size() const;                   // Number of elements in the current slab
+        hsize_t num_slabs() const;
+        std::vector<hsize_t> start() const;     // Index, in the region, of the first element of the current slab
+        std::vector<hsize_t> shape() const;     // Shape of the current slab
+    };
+
+}
+
+#endif
@@ -0,0 +1,275 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5timeseries.cc
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#include "h5timeseries.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+
+#include "h5group.h"
+#include "h5dataset.h"
+#include "h5attribute.h"
+
+namespace h5 {
+
+    //Create the time series 'name' in parent, steps are written with the default plan
+    TimeSeries::TimeSeries(Group &parent, std::string name, std::vector<hsize_t> shape, std::string dtype, int keyframe_interval, DatasetOptions options) {
+        this->group_ = new Group(&parent, name, "a");
+        this->shape_ = shape;
+        this->dtype_ = dtype;
+        this->keyframe_interval_ = std::max(keyframe_interval, 1);
+        this->options_ = options;
+        this->has_plan_ = false;
+        this->num_steps_ = 0;
+
+        write_attribute(this->group_->id(), "shape", shape);
+        write_attribute(this->group_->id(), "dtype", dtype);
+        write_attribute(this->group_->id(), "keyframe_interval", this->keyframe_interval_);
+        write_attribute(this->group_->id(), "num_steps", this->num_steps_);
+
+        this->init();
+    }
+
+    //Create the time series 'name' in parent, steps are written with plan
+    TimeSeries::TimeSeries(Group &parent, std::string name, Plan plan, std::string dtype, int keyframe_interval, DatasetOptions options) {
+        this->group_ = new Group(&parent, name, "a");
+        this->shape_ = plan.filespace_dimension();
+        this->dtype_ = dtype;
+        this->keyframe_interval_ = std::max(keyframe_interval, 1);
+        this->options_ = options;
+        this->has_plan_ = true;
+        this->plan_ = plan;
+        this->num_steps_ = 0;
+
+        write_attribute(this->group_->id(), "shape", this->shape_);
+        write_attribute(this->group_->id(), "dtype", dtype);
+        write_attribute(this->group_->id(), "keyframe_interval", this->keyframe_interval_);
+        write_attribute(this->group_->id(), "num_steps", this->num_steps_);
+
+        this->init();
+    }
+
+    //Open the time series 'name' in parent, steps are read with the default plan until set_plan()
+    TimeSeries::TimeSeries(Group &parent, std::string name) {
+        this->group_ = new Group(&parent, name, "r");
+        this->has_plan_ = false;
+
+        std::vector<int> keyframe_interval;
+        std::vector<hsize_t> num_steps;
+
+        if (read_attribute(this->group_->id(), "shape", this->shape_) < 0 || read_attribute(this->group_->id(), "dtype", this->dtype_) < 0
+            || read_attribute(this->group_->id(), "keyframe_interval", keyframe_interval) < 0 || read_attribute(this->group_->id(), "num_steps", num_steps) < 0) {
+            std::cerr << "TimeSeries: " << name << " is not a time series" << std::endl;
+            exit(1);
+        }
+
+        this->keyframe_interval_ = keyframe_interval[0];
+        this->num_steps_ = num_steps[0];
+
+        this->init();
+    }
+
+    void TimeSeries::init() {
+        switch (H5Tget_size(Dtype(this->dtype_))) {
+            case 1: this->delta_dtype_ = "uchar"; break;
+            case 2: this->delta_dtype_ = "ushort"; break;
+            case 4: this->delta_dtype_ = "uint"; break;
+            case 8: this->delta_dtype_ = "ullong"; break;
+            default:
+                std::cerr << "TimeSeries: datatype " << this->dtype_ << " is not of 1, 2, 4 or 8 bytes" << std::endl;
+                exit(1);
+        }
+
+        this->next_step_ = 0;
+        this->has_previous_ = false;
+        this->has_cached_ = false;
+    }
+
+    TimeSeries::~TimeSeries() {
+        delete this->group_;
+    }
+
+    TimeSeries &TimeSeries::set_plan(Plan plan) {
+        this->has_plan_ = true;
+        this->plan_ = plan;
+
+        this->has_previous_ = false;
+        this->has_cached_ = false;
+        return *this;
+    }
+
+    hsize_t TimeSeries::num_steps() const {
+        return this->num_steps_;
+    }
+
+    int TimeSeries::keyframe_interval() const {
+        return this->keyframe_interval_;
+    }
+
+    //Step read by the next >>
+    TimeSeries &TimeSeries::seek(hsize_t step) {
+        this->next_step_ = step;
+        return *this;
+    }
+
+    hsize_t TimeSeries::tell() const {
+        return this->next_step_;
+    }
+
+    std::string TimeSeries::step_name(hsize_t step) const {
+        std::ostringstream name;
+        name << "step" << step;
+        return name.str();
+    }
+
+    //XOR of n bytes of src into dst, 8 bytes at a time
+    static void Xor_bytes(char *dst, const char *src, size_t n) {
+        size_t i = 0;
+
+        for (; i+8<=n; i+=8) {
+            unsigned long long a, b;
+            memcpy(&a, dst+i, 8);
+            memcpy(&b, src+i, 8);
+            a ^= b;
+            memcpy(dst+i, &a, 8);
+        }
+
+        for (; i<n; i++)
+            dst[i] ^= src[i];
+    }
+
+    //Append a step, data holds the memoryspace of the plan in the series' datatype
+    void TimeSeries::write(const void *data) {
+        hsize_t step = this->num_steps_;
+        bool keyframe = (step % this->keyframe_interval_ == 0);
+        std::string dtype = (keyframe ? this->dtype_ : this->delta_dtype_);
+
+        //Reopened series, the previous step is reconstructed once
+        if (!keyframe && !this->has_previous_) {
+            this->read(step-1, NULL);
+            this->previous_ = this->cached_;
+        }
+
+        Dataset ds = (this->has_plan_ ? Dataset(this->group_, this->step_name(step), this->plan_, dtype, this->options_)
+                                      : Dataset(this->group_, this->step_name(step), this->shape_, dtype, this->options_));
+
+        size_t size = H5Sget_simple_extent_npoints(ds.plan.memoryspace())*H5Tget_size(Dtype(dtype));
+        const char *step_data = static_cast<const char*>(data);
+
+        std::vector<char> delta;
+        if (!keyframe) {
+            delta.assign(step_data, step_data + size);
+            Xor_bytes(delta.data(), this->previous_.data(), size);
+            ds.write(Dtype(dtype), delta.data());
+        }
+        else
+            ds.write(Dtype(dtype), step_data);
+
+        ds.close();
+
+        this->previous_.assign(step_data, step_data + size);
+        this->has_previous_ = true;
+
+        this->num_steps_++;
+        write_attribute(this->group_->id(), "num_steps", this->num_steps_);
+    }
+
+    //Read step in datatype dtype into buffer, resized to the memoryspace of the plan
+    void TimeSeries::read_step(hsize_t step, std::string dtype, std::vector<char> &buffer) const {
+        Dataset ds(this->group_, this->step_name(step));
+
+        if (this->has_plan_)
+            ds.set_plan(this->plan_);
+
+        buffer.resize(H5Sget_simple_extent_npoints(ds.plan.memoryspace())*H5Tget_size(Dtype(dtype)));
+        ds.read(Dtype(dtype), buffer.data());
+    }
+
+    //Read step into data, which holds the memoryspace of the plan in the series' datatype
+    void TimeSeries::read(hsize_t step, void *data) {
+        if (step >= this->num_steps_) {
+            std::cerr << "TimeSeries::read: step " << step << " of " << this->num_steps_ << " steps" << std::endl;
+            exit(1);
+        }
+
+        hsize_t keyframe = step - step % this->keyframe_interval_;
+        hsize_t s;
+
+        //Continue from the step read last when it lies between the keyframe and step
+        if (this->has_cached_ && this->cached_step_ >= keyframe && this->cached_step_ <= step)
+            s = this->cached_step_;
+        else {
+            this->read_step(keyframe, this->dtype_, this->cached_);
+            s = keyframe;
+        }
+
+        std::vector<char> delta;
+
+        for (s++; s<=step; s++) {
+            this->read_step(s, this->delta_dtype_, delta);
+            Xor_bytes(this->cached_.data(), delta.data(), std::min(delta.size(), this->cached_.size()));
+        }
+
+        this->cached_step_ = step;
+        this->has_cached_ = true;
+
+        if (data != NULL)
+            memcpy(data, this->cached_.data(), this->cached_.size());
+    }
+
+    //Read the step at the read position into data, reconstructed from its keyframe and deltas, and advance
+    TimeSeries &operator>>(TimeSeries &series, void *data) {
+        series.read(series.tell(), data);
+        series.seek(series.tell()+1);
+        return series;
+    }
+
+    //Append data as the next step
+    TimeSeries &operator<<(TimeSeries &series, const void *data) {
+        series.write(data);
+        return series;
+    }
+
+}
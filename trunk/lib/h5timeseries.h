@@ -0,0 +1,135 @@
+/* H5SI
+ *
+ * Copyright (C) 2020, Mahendra K. Verma, Anando Gopal Chatterjee
+ *
+ * Mahendra K. Verma
+ * Indian Institute of Technology, Kanpur-208016
+ * UP, India
+ *
+ * mkv@iitk.ac.in
+ *
+ * This file is part of H5SI.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file  h5timeseries.h
+ * @author  A. G. Chatterjee
+ * @date feb 2012
+ * @bug  No known bugs
+ */
+
+#ifndef _H_H5TIMESERIES
+#define _H_H5TIMESERIES
+
+#include <hdf5.h>
+#include <string>
+#include <vector>
+
+#include "h5plan.h"
+#include "h5options.h"
+#include "h5datatype.h"
+
+namespace h5 {
+
+    class Group;
+
+    /**
+     * Snapshots of a field over time, stored as the group 'name' with one dataset per step,
+     * e.g.
+     *
+     *     h5::TimeSeries U(f, "U.V1", h5::shape(N,N,N), "float", 16, h5::DatasetOptions().chunk(h5::shape(N,N,N/4)).deflate(4));
+     *     for (int t=0; t<num_steps; t++)
+     *         U << u.data();
+     *
+     *     h5::TimeSeries V(f, "U.V1");
+     *     V.seek(t) >> u.data();     // step t, then t+1 on the next >>
+     *
+     * Every keyframe_interval-th step is stored as is, the others as the bitwise XOR with the
+     * previous step, held in an unsigned integer datatype of the same width. Consecutive
+     * snapshots share sign, exponent and leading mantissa bits, so the deltas are mostly zero
+     * bytes and compress well with the shuffle and deflate filters of the options.
+     *
+     * Reading step s reads the keyframe before s and the deltas up to s, unless it follows the
+     * step read last, which is kept, so reading the steps in order with >> reads every dataset
+     * once. write() is the same as <<, appending the next step, and read() reads the given step
+     * without moving the position of >>. Steps are read and written with the plan given at
+     * creation, or with the default plan of the datasets, the memory buffer holding the whole
+     * memoryspace.
+     * Only datatypes of 1, 2, 4 or 8 bytes are supported.
+     */
+    class TimeSeries
+    {
+        Group *group_;
+        std::vector<hsize_t> shape_;
+        std::string dtype_;
+        std::string delta_dtype_;
+        int keyframe_interval_;
+        DatasetOptions options_;
+
+        bool has_plan_;
+        Plan plan_;
+
+        hsize_t num_steps_;
+        hsize_t next_step_;                 // Step read by the next >>
+
+        std::vector<char> previous_;        // Last step written, XORed with the next one
+        bool has_previous_;
+
+        std::vector<char> cached_;          // Last step read
+        hsize_t cached_step_;
+        bool has_cached_;
+
+        void init();
+        std::string step_name(hsize_t step) const;
+        void read_step(hsize_t step, std::string dtype, std::vector<char> &buffer) const;
+
+        TimeSeries(const TimeSeries &series);
+        TimeSeries &operator=(const TimeSeries &series);
+
+    public:
+        TimeSeries(Group &parent, std::string name, std::vector<hsize_t> shape, std::string dtype, int keyframe_interval=16, DatasetOptions options=DatasetOptions());
+        TimeSeries(Group &parent, std::string name, Plan plan, std::string dtype, int keyframe_interval=16, DatasetOptions options=DatasetOptions());
+        TimeSeries(Group &parent, std::string name);
+        ~TimeSeries();
+
+        TimeSeries &set_plan(Plan plan);
+
+        hsize_t num_steps() const;
+        int keyframe_interval() const;
+
+        void write(const void *data);
+        void read(hsize_t step, void *data);
+
+        TimeSeries &seek(hsize_t step);
+        hsize_t tell() const;
+    };
+
+    TimeSeries &operator>>(TimeSeries &series, void *data);
+    TimeSeries &operator<<(TimeSeries &series, const void *data);
+
+}
+
+#endif